@@ -46,6 +46,15 @@ bool CpuInfo::detect_OS_AVX()
     return avxSupported;
 }
 
+bool CpuInfo::detect_OS_AVX512()
+{
+    if (!detect_OS_AVX()) return false;
+
+    /* the OS has to save the opmask registers and the upper halves of the zmm registers */
+    uint64_t xcrFeatureMask = xgetbv(0);
+    return (xcrFeatureMask & 0xE6) == 0xE6;
+}
+
 CpuInfo::CpuInfo() : supportedFeatures(0)
 {
     int regs[4];
@@ -73,6 +82,18 @@ CpuInfo::CpuInfo() : supportedFeatures(0)
             cpuid(regs, 0x00000007, 0);
 
             if ((regs[1] & ((int)1 << 5))) supportedFeatures |= CPU_FEATURE_AVX2;
+
+            if (detect_OS_AVX512()) {
+                if ((regs[1] & ((int)1 << 16))) supportedFeatures |= CPU_FEATURE_AVX512F;
+
+                if ((regs[1] & ((int)1 << 17))) supportedFeatures |= CPU_FEATURE_AVX512DQ;
+
+                if ((regs[1] & ((int)1 << 28))) supportedFeatures |= CPU_FEATURE_AVX512CD;
+
+                if ((regs[1] & ((int)1 << 30))) supportedFeatures |= CPU_FEATURE_AVX512BW;
+
+                if ((uint32_t)regs[1] & ((uint32_t)1 << 31)) supportedFeatures |= CPU_FEATURE_AVX512VL;
+            }
         }
     }
 }
@@ -9,6 +9,11 @@
 #define CPU_FEATURE_SSE4_2 (1 << 4)
 #define CPU_FEATURE_AVX (1 << 5)
 #define CPU_FEATURE_AVX2 (1 << 7)
+#define CPU_FEATURE_AVX512F (1 << 8)
+#define CPU_FEATURE_AVX512CD (1 << 9)
+#define CPU_FEATURE_AVX512BW (1 << 10)
+#define CPU_FEATURE_AVX512DQ (1 << 11)
+#define CPU_FEATURE_AVX512VL (1 << 12)
 
 struct CpuInfo {
 private:
@@ -28,5 +33,6 @@ public:
 
 private:
     static bool detect_OS_AVX();
+    static bool detect_OS_AVX512();
     uint32_t supportedFeatures;
 };
@@ -16,6 +16,9 @@ cdef extern from "rapidfuzz.h":
     uint32_t RF_SCORER_FLAG_SYMMETRIC
     uint32_t RF_SCORER_FLAG_TRIANGLE_INEQUALITY
     uint32_t RF_SCORER_NONE_IS_WORST_SCORE
+    uint32_t RF_SCORER_FLAG_LENGTH_BOUND
+    uint32_t RF_SCORER_FLAG_LCS_BOUND
+    uint32_t RF_SCORER_FLAG_MULTI_STRING_LONG
 
     ctypedef struct RF_String:
         void (*dtor) (RF_String*) nogil
@@ -44,11 +47,16 @@ cdef extern from "rapidfuzz.h":
         bool (*f64) (const RF_ScorerFunc*, const RF_String*, int64_t, double, double*) except False nogil
         bool (*i64) (const RF_ScorerFunc*, const RF_String*, int64_t, int64_t, int64_t*) except False nogil
 
+    ctypedef union _RF_ScorerFunc_batch_union:
+        bool (*f64) (const RF_ScorerFunc*, const RF_String*, int64_t, const double*, double, double*) except False nogil
+        bool (*i64) (const RF_ScorerFunc*, const RF_String*, int64_t, const int64_t*, int64_t, int64_t*) except False nogil
+
     ctypedef struct RF_ScorerFunc:
         void (*dtor) (RF_ScorerFunc*) nogil
         _RF_ScorerFunc_union call
 
         void* context
+        _RF_ScorerFunc_batch_union call_batch
 
     ctypedef bool (*RF_ScorerFuncInit) (RF_ScorerFunc*, const RF_Kwargs*, int64_t, const RF_String*) except False nogil
 
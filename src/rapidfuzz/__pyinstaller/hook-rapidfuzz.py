@@ -3,15 +3,27 @@ from __future__ import annotations
 
 hiddenimports = [
     "array",
+    "rapidfuzz._feature_detector_cpp",
     "rapidfuzz.fuzz_py",
     "rapidfuzz.fuzz_cpp",
+    "rapidfuzz.fuzz_cpp_sse2",
+    "rapidfuzz.fuzz_cpp_avx2",
+    "rapidfuzz.fuzz_cpp_avx512",
     "rapidfuzz.utils_py",
     "rapidfuzz.utils_cpp",
+    "rapidfuzz.utils_cpp_sse2",
+    "rapidfuzz.utils_cpp_avx2",
     "rapidfuzz.process_py",
     "rapidfuzz.process_cpp",
+    "rapidfuzz.process_cpp_impl",
+    "rapidfuzz.process_cpp_impl_avx2",
+    "rapidfuzz.process_cpp_impl_avx512",
     # distances
     "rapidfuzz.distance._initialize_py",
     "rapidfuzz.distance._initialize_cpp",
     "rapidfuzz.distance.metrics_cpp",
+    "rapidfuzz.distance.metrics_cpp_sse2",
+    "rapidfuzz.distance.metrics_cpp_avx2",
+    "rapidfuzz.distance.metrics_cpp_avx512",
     "rapidfuzz.distance.metrics_py",
 ]
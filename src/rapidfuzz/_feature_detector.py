@@ -2,14 +2,32 @@
 # Copyright (C) 2022 Max Bachmann
 from __future__ import annotations
 
-__all__ = ["AVX2", "SSE2", "supports"]
+__all__ = ["AVX2", "AVX512", "SSE2", "supports"]
 
 try:
-    from rapidfuzz._feature_detector_cpp import AVX2, SSE2, supports
+    from rapidfuzz._feature_detector_cpp import (
+        AVX2,
+        AVX512BW,
+        AVX512CD,
+        AVX512DQ,
+        AVX512F,
+        AVX512VL,
+        SSE2,
+        supports,
+    )
 except ImportError:
     SSE2 = 1
     AVX2 = 2
+    AVX512F = 4
+    AVX512CD = 8
+    AVX512BW = 16
+    AVX512DQ = 32
+    AVX512VL = 64
 
     def supports(features):
         _ = features
         return False
+
+
+# features enabled by /arch:AVX512 on MSVC, which are all supported since Skylake-SP
+AVX512 = AVX512F | AVX512CD | AVX512BW | AVX512DQ | AVX512VL
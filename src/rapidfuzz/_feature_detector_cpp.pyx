@@ -7,6 +7,11 @@ from libc.stdint cimport uint32_t
 cdef extern from "FeatureDetector/CpuInfo.hpp":
     cdef int CPU_FEATURE_SSE2
     cdef int CPU_FEATURE_AVX2
+    cdef int CPU_FEATURE_AVX512F
+    cdef int CPU_FEATURE_AVX512CD
+    cdef int CPU_FEATURE_AVX512BW
+    cdef int CPU_FEATURE_AVX512DQ
+    cdef int CPU_FEATURE_AVX512VL
 
     cdef cppclass CpuInfo:
         @staticmethod
@@ -14,6 +19,11 @@ cdef extern from "FeatureDetector/CpuInfo.hpp":
 
 SSE2 = CPU_FEATURE_SSE2
 AVX2 = CPU_FEATURE_AVX2
+AVX512F = CPU_FEATURE_AVX512F
+AVX512CD = CPU_FEATURE_AVX512CD
+AVX512BW = CPU_FEATURE_AVX512BW
+AVX512DQ = CPU_FEATURE_AVX512DQ
+AVX512VL = CPU_FEATURE_AVX512VL
 
 def supports(uint32_t features):
     return CpuInfo.supports(features)
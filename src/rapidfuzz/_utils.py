@@ -5,17 +5,19 @@ from __future__ import annotations
 
 import importlib
 import os
+import re
 from enum import IntFlag
 from math import isnan
 from typing import Any, Callable
 
-from rapidfuzz._feature_detector import AVX2, SSE2, supports
+from rapidfuzz._feature_detector import AVX2, AVX512, SSE2, supports
 
 
 class ScorerFlag(IntFlag):
     RESULT_F64 = 1 << 5
     RESULT_I64 = 1 << 6
     SYMMETRIC = 1 << 11
+    TRIANGLE_INEQUALITY = 1 << 12 | SYMMETRIC
 
 
 def _get_scorer_flags_distance(**_kwargs: Any) -> dict[str, Any]:
@@ -26,6 +28,14 @@ def _get_scorer_flags_distance(**_kwargs: Any) -> dict[str, Any]:
     }
 
 
+def _get_scorer_flags_metric_distance(**_kwargs: Any) -> dict[str, Any]:
+    return {
+        "optimal_score": 0,
+        "worst_score": 2**63 - 1,
+        "flags": ScorerFlag.RESULT_I64 | ScorerFlag.TRIANGLE_INEQUALITY,
+    }
+
+
 def _get_scorer_flags_similarity(**_kwargs: Any) -> dict[str, Any]:
     return {
         "optimal_score": 2**63 - 1,
@@ -66,6 +76,22 @@ def add_scorer_attrs(func: Any, cached_scorer_call: dict[str, Callable[..., dict
     func._RF_OriginalScorer = func
 
 
+def processor_name(processor: Any) -> str:
+    """
+    name of a processor, which is stored in corpus files. The Python and C++ implementations
+    of the processors in rapidfuzz share their name
+    """
+    if processor is None:
+        return ""
+
+    module = getattr(processor, "__module__", None) or ""
+    name = getattr(processor, "__qualname__", None) or type(processor).__qualname__
+    if module.startswith("rapidfuzz."):
+        module = re.sub(r"_(py|cpp(_sse2|_avx2|_avx512)?)$", "", module)
+
+    return f"{module}.{name}" if module else name
+
+
 def optional_import_module(module: str) -> Any:
     """
     try to import module. Return None on failure
@@ -80,6 +106,10 @@ def vectorized_import(name: str) -> tuple[Any, list[Any]]:
     """
     import module best fitting for current CPU
     """
+    if supports(AVX512):
+        module = optional_import_module(name + "_avx512")
+        if module is not None:
+            return module
     if supports(AVX2):
         module = optional_import_module(name + "_avx2")
         if module is not None:
@@ -127,6 +157,10 @@ def fallback_import(
 
 
 default_distance_attribute: dict[str, Callable[..., dict[str, Any]]] = {"get_scorer_flags": _get_scorer_flags_distance}
+# distance adhering to the triangle inequality
+metric_distance_attribute: dict[str, Callable[..., dict[str, Any]]] = {
+    "get_scorer_flags": _get_scorer_flags_metric_distance
+}
 default_similarity_attribute: dict[str, Callable[..., dict[str, Any]]] = {
     "get_scorer_flags": _get_scorer_flags_similarity
 }
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/*
+ * BK-tree of process.Corpus for distances adhering to the triangle inequality.
+ *
+ * Each node stores the index of a string. The children of a node are grouped by their distance
+ * to it, which is stored as edge of the child. For a string within the distance r of the query
+ * and a node at the distance d from the query, the triangle inequality requires the edge
+ * leading to the string to lie in [d - r, d + r], so all other children can be skipped.
+ */
+class BKTree {
+public:
+    void clear()
+    {
+        m_nodes.clear();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_nodes.empty();
+    }
+
+    size_t size() const noexcept
+    {
+        return m_nodes.size();
+    }
+
+    /**
+     * @brief inserts the string `index`. `distance(node_index)` returns the distance between
+     * this string and the string `node_index`, which is already part of the tree
+     */
+    template <typename DistanceFunc>
+    void insert(int64_t index, DistanceFunc&& distance)
+    {
+        if (m_nodes.empty()) {
+            m_nodes.push_back({index, 0, 0, no_node, no_node});
+            return;
+        }
+
+        size_t node = 0;
+        while (true) {
+            int64_t dist = distance(m_nodes[node].index);
+            size_t child = m_nodes[node].first_child;
+            while (child != no_node && m_nodes[child].edge != dist)
+                child = m_nodes[child].next_sibling;
+
+            if (child == no_node) {
+                m_nodes.push_back({index, dist, 0, no_node, m_nodes[node].first_child});
+                m_nodes[node].first_child = m_nodes.size() - 1;
+                m_nodes[node].max_edge = std::max(m_nodes[node].max_edge, dist);
+                return;
+            }
+            node = child;
+        }
+    }
+
+    /**
+     * @brief visits all strings, which can lie within the distance `radius()` of the query.
+     * `distance(index, max_distance)` returns the distance between the query and the string
+     * `index`. It only has to be exact when it does not exceed `max_distance`.
+     * `match(index, distance)` is called for each of these distances. The radius is queried
+     * again for each node, so it can shrink while the tree is searched.
+     */
+    template <typename DistanceFunc, typename RadiusFunc, typename MatchFunc>
+    void search(DistanceFunc&& distance, RadiusFunc&& radius, MatchFunc&& match) const
+    {
+        if (m_nodes.empty()) return;
+
+        std::vector<size_t> stack = {0};
+        std::vector<std::pair<int64_t, size_t>> children;
+        while (!stack.empty()) {
+            const Node& node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            /* beyond this distance the triangle inequality excludes all children */
+            int64_t max_distance = saturated_add(radius(), node.max_edge);
+            int64_t dist = distance(node.index, max_distance);
+            match(node.index, dist);
+            if (dist > max_distance) continue;
+
+            int64_t r = radius();
+            children.clear();
+            for (size_t child = node.first_child; child != no_node; child = m_nodes[child].next_sibling) {
+                int64_t diff = m_nodes[child].edge > dist ? m_nodes[child].edge - dist
+                                                          : dist - m_nodes[child].edge;
+                if (diff <= r) children.emplace_back(diff, child);
+            }
+
+            /* the closest children are searched first, since they are the most likely
+             * to shrink the radius */
+            std::sort(children.begin(), children.end(), std::greater<std::pair<int64_t, size_t>>());
+            for (const auto& child : children)
+                stack.push_back(child.second);
+        }
+    }
+
+private:
+    static constexpr size_t no_node = std::numeric_limits<size_t>::max();
+
+    static int64_t saturated_add(int64_t a, int64_t b)
+    {
+        return (a > std::numeric_limits<int64_t>::max() - b) ? std::numeric_limits<int64_t>::max() : a + b;
+    }
+
+    struct Node {
+        int64_t index;
+        /* distance to the parent */
+        int64_t edge;
+        /* largest edge of the children */
+        int64_t max_edge;
+        size_t first_child;
+        size_t next_sibling;
+    };
+
+    std::vector<Node> m_nodes;
+};
@@ -0,0 +1,355 @@
+#pragma once
+#include "cpp_common.hpp"
+#include "rapidfuzz.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Binary file format of process.Corpus, which is designed to be memory mapped. The strings
+ * are stored in the representation used by RF_String, so they are used in place without
+ * copying them.
+ *
+ * The file consists of:
+ * - CorpusFileHeader
+ * - one CorpusFileTable per stored list of strings. The first one holds the choices, the
+ *   second one (if present) holds the output of the processor for each of them
+ * - the UTF-8 encoded name of this processor, so the file can not be loaded with another one
+ * - for each table: one CorpusFileEntry per string followed by the characters of all strings
+ *   grouped into a segment per RF_StringType (Latin-1, UCS-2 and UCS-4)
+ *
+ * All values are stored in the byte order of the machine writing the file and every section
+ * starts at a multiple of 64 bytes.
+ */
+
+static constexpr char corpus_file_magic[8] = {'R', 'F', 'C', 'O', 'R', 'P', 'U', 'S'};
+static constexpr uint32_t corpus_file_version = 2;
+static constexpr uint32_t corpus_file_byte_order = 0x01020304;
+/* kind of the entries storing None */
+static constexpr uint32_t corpus_file_none = 0xFFFFFFFF;
+static constexpr size_t corpus_file_segment_count = 3;
+
+struct CorpusFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t count;
+    uint64_t table_count;
+    /* offset and length in bytes of the processor name. It is empty without a processor */
+    uint64_t processor_offset;
+    uint64_t processor_length;
+};
+
+struct CorpusFileTable {
+    uint64_t entries_offset;
+    /* offset in bytes and length in characters of the segment for each RF_StringType */
+    uint64_t segment_offset[corpus_file_segment_count];
+    uint64_t segment_length[corpus_file_segment_count];
+};
+
+struct CorpusFileEntry {
+    /* offset in characters into the segment of the string kind */
+    uint64_t offset;
+    uint64_t length;
+    uint32_t kind;
+    uint32_t reserved;
+};
+
+static inline size_t corpus_file_align(size_t offset)
+{
+    return (offset + 63) & ~static_cast<size_t>(63);
+}
+
+static inline size_t corpus_file_char_size(size_t kind)
+{
+    return size_t(1) << kind;
+}
+
+/**
+ * @brief narrowest kind the string fits into. This matches the kind Python uses for a str, even
+ * when the string was created by a processor, which keeps the kind of its input.
+ */
+static inline uint32_t corpus_file_kind(const RF_String& str)
+{
+    uint64_t max_char = visit(str, [](auto s) {
+        uint64_t res = 0;
+        for (auto ch : s)
+            res = std::max<uint64_t>(res, static_cast<uint64_t>(ch));
+        return res;
+    });
+
+    if (max_char <= 0xFF) return RF_UINT8;
+    if (max_char <= 0xFFFF) return RF_UINT16;
+    return RF_UINT32;
+}
+
+template <typename CharT>
+static inline void corpus_file_copy(char* dest, const RF_String& str)
+{
+    visit(str, [&](auto s) {
+        for (auto ch : s) {
+            CharT out = static_cast<CharT>(ch);
+            memcpy(dest, &out, sizeof(CharT));
+            dest += sizeof(CharT);
+        }
+    });
+}
+
+/**
+ * @brief writes lists of strings in the corpus file format. The size of the file is known
+ * upfront, so the caller can map the output file and let the writer fill it in place.
+ */
+class CorpusFileWriter {
+public:
+    /**
+     * @brief adds a list of strings. The first one holds the choices and the second one the
+     * processed choices. The strings are only referenced, so they have to outlive the writer.
+     */
+    void add_table(const std::vector<RF_StringWrapper>& strings)
+    {
+        if (m_tables.size() == 2) throw std::invalid_argument("corpus file stores at most two tables");
+        if (!m_tables.empty() && strings.size() != m_tables[0]->size())
+            throw std::invalid_argument("all tables require the same length");
+
+        CorpusFileTable table = {};
+        std::vector<uint8_t> kinds;
+        kinds.reserve(strings.size());
+        for (const auto& str : strings) {
+            if (str.is_none()) {
+                kinds.push_back(none_kind);
+                continue;
+            }
+            if (str.string.kind == RF_UINT64)
+                throw std::invalid_argument("only strings can be stored in a corpus file");
+
+            uint32_t kind = corpus_file_kind(str.string);
+            kinds.push_back(static_cast<uint8_t>(kind));
+            table.segment_length[kind] += static_cast<uint64_t>(str.size());
+        }
+
+        m_tables.push_back(&strings);
+        m_kinds.push_back(std::move(kinds));
+        m_layout.push_back(table);
+        update_layout();
+    }
+
+    /**
+     * @brief name of the processor, which created the second table
+     */
+    void set_processor(const std::string& name)
+    {
+        m_processor = name;
+        if (!m_tables.empty()) update_layout();
+    }
+
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief writes the file into `dest`, which has to provide size() bytes
+     */
+    void write(char* dest) const
+    {
+        if (m_tables.empty()) throw std::invalid_argument("corpus file requires at least one table");
+        if ((m_tables.size() == 2) != !m_processor.empty())
+            throw std::invalid_argument("the processed choices require the name of the processor");
+        memset(dest, 0, m_size);
+
+        CorpusFileHeader header = {};
+        memcpy(header.magic, corpus_file_magic, sizeof(header.magic));
+        header.version = corpus_file_version;
+        header.byte_order = corpus_file_byte_order;
+        header.count = static_cast<uint64_t>(m_tables[0]->size());
+        header.table_count = static_cast<uint64_t>(m_tables.size());
+        header.processor_offset = static_cast<uint64_t>(processor_offset());
+        header.processor_length = static_cast<uint64_t>(m_processor.size());
+        memcpy(dest, &header, sizeof(header));
+        memcpy(dest + sizeof(header), m_layout.data(), m_layout.size() * sizeof(CorpusFileTable));
+        memcpy(dest + header.processor_offset, m_processor.data(), m_processor.size());
+
+        for (size_t t = 0; t < m_tables.size(); ++t) {
+            const CorpusFileTable& table = m_layout[t];
+            uint64_t segment_pos[corpus_file_segment_count] = {};
+            char* entries = dest + table.entries_offset;
+
+            for (size_t i = 0; i < m_tables[t]->size(); ++i) {
+                const RF_StringWrapper& str = (*m_tables[t])[i];
+                CorpusFileEntry entry = {};
+                if (m_kinds[t][i] == none_kind) {
+                    entry.kind = corpus_file_none;
+                }
+                else {
+                    entry.kind = m_kinds[t][i];
+                    entry.offset = segment_pos[entry.kind];
+                    entry.length = static_cast<uint64_t>(str.size());
+
+                    char* chars = dest + table.segment_offset[entry.kind] +
+                                  entry.offset * corpus_file_char_size(entry.kind);
+                    if (entry.kind == RF_UINT8)
+                        corpus_file_copy<uint8_t>(chars, str.string);
+                    else if (entry.kind == RF_UINT16)
+                        corpus_file_copy<uint16_t>(chars, str.string);
+                    else
+                        corpus_file_copy<uint32_t>(chars, str.string);
+                    segment_pos[entry.kind] += entry.length;
+                }
+
+                memcpy(entries, &entry, sizeof(entry));
+                entries += sizeof(entry);
+            }
+        }
+    }
+
+private:
+    size_t processor_offset() const
+    {
+        return sizeof(CorpusFileHeader) + m_layout.size() * sizeof(CorpusFileTable);
+    }
+
+    void update_layout()
+    {
+        size_t count = m_tables[0]->size();
+        size_t offset = corpus_file_align(processor_offset() + m_processor.size());
+        for (auto& table : m_layout) {
+            table.entries_offset = offset;
+            offset = corpus_file_align(offset + count * sizeof(CorpusFileEntry));
+
+            for (size_t kind = 0; kind < corpus_file_segment_count; ++kind) {
+                table.segment_offset[kind] = offset;
+                offset = corpus_file_align(offset + table.segment_length[kind] * corpus_file_char_size(kind));
+            }
+        }
+        m_size = offset;
+    }
+
+    std::vector<const std::vector<RF_StringWrapper>*> m_tables;
+    /* kind each string is stored as */
+    static constexpr uint8_t none_kind = 0xFF;
+    std::vector<std::vector<uint8_t>> m_kinds;
+    std::vector<CorpusFileTable> m_layout;
+    std::string m_processor;
+    size_t m_size = 0;
+};
+
+/**
+ * @brief read only view of a corpus file, e.g. in a memory mapping. The strings returned
+ * point into the file, so it has to stay alive as long as they are used.
+ */
+class CorpusFileView {
+public:
+    CorpusFileView() : m_data(nullptr), m_size(0), m_count(0)
+    {}
+
+    CorpusFileView(const char* data, size_t size) : m_data(data), m_size(size)
+    {
+        CorpusFileHeader header;
+        if (size < sizeof(header)) throw std::invalid_argument("corpus file is truncated");
+        memcpy(&header, data, sizeof(header));
+
+        if (memcmp(header.magic, corpus_file_magic, sizeof(header.magic)) != 0)
+            throw std::invalid_argument("file is not a corpus file");
+        if (header.version != corpus_file_version)
+            throw std::invalid_argument("unsupported corpus file version");
+        if (header.byte_order != corpus_file_byte_order)
+            throw std::invalid_argument("corpus file was written on a machine with a different byte order");
+        if (header.table_count < 1 || header.table_count > 2 ||
+            (header.table_count == 2) != (header.processor_length != 0))
+            throw std::invalid_argument("corpus file is corrupted");
+
+        if (sizeof(header) + header.table_count * sizeof(CorpusFileTable) > size ||
+            !in_bounds(header.processor_offset, header.processor_length, 1))
+            throw std::invalid_argument("corpus file is truncated");
+        m_processor.assign(data + header.processor_offset, static_cast<size_t>(header.processor_length));
+
+        m_count = static_cast<size_t>(header.count);
+        m_tables.resize(static_cast<size_t>(header.table_count));
+        memcpy(m_tables.data(), data + sizeof(header), m_tables.size() * sizeof(CorpusFileTable));
+
+        for (const auto& table : m_tables) {
+            if (table.entries_offset % alignof(CorpusFileEntry) != 0 ||
+                !in_bounds(table.entries_offset, header.count, sizeof(CorpusFileEntry)))
+                throw std::invalid_argument("corpus file is truncated");
+
+            for (size_t kind = 0; kind < corpus_file_segment_count; ++kind) {
+                size_t char_size = corpus_file_char_size(kind);
+                if (table.segment_offset[kind] % char_size != 0 ||
+                    !in_bounds(table.segment_offset[kind], table.segment_length[kind], char_size))
+                    throw std::invalid_argument("corpus file is truncated");
+            }
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+    size_t table_count() const noexcept
+    {
+        return m_tables.size();
+    }
+
+    /* name of the processor the file was saved with. Empty without a processor */
+    const std::string& processor() const noexcept
+    {
+        return m_processor;
+    }
+
+    /**
+     * @brief string `index` of table `table`. None is returned as a string with data set to nullptr
+     */
+    RF_String get(size_t table, size_t index) const
+    {
+        const CorpusFileTable& layout = m_tables.at(table);
+        if (index >= m_count) throw std::out_of_range("corpus file index out of range");
+
+        const auto* entries = reinterpret_cast<const CorpusFileEntry*>(m_data + layout.entries_offset);
+        const CorpusFileEntry& entry = entries[index];
+
+        RF_String str = {nullptr, RF_UINT8, nullptr, 0, nullptr};
+        if (entry.kind == corpus_file_none) return str;
+
+        if (entry.kind >= corpus_file_segment_count || entry.offset > layout.segment_length[entry.kind] ||
+            entry.length > layout.segment_length[entry.kind] - entry.offset)
+            throw std::invalid_argument("corpus file is corrupted");
+
+        str.kind = static_cast<RF_StringType>(entry.kind);
+        /* empty strings still point into the file, since nullptr marks None */
+        str.data = const_cast<char*>(m_data + layout.segment_offset[entry.kind] +
+                                     entry.offset * corpus_file_char_size(entry.kind));
+        str.length = static_cast<int64_t>(entry.length);
+        return str;
+    }
+
+    /**
+     * @brief all strings of table `table`. They point into the file and are not copied
+     */
+    std::vector<RF_StringWrapper> strings(size_t table) const
+    {
+        std::vector<RF_StringWrapper> res;
+        res.reserve(m_count);
+        for (size_t i = 0; i < m_count; ++i)
+            res.emplace_back(get(table, i));
+
+        return res;
+    }
+
+private:
+    bool in_bounds(uint64_t offset, uint64_t count, size_t elem_size) const
+    {
+        if (offset > m_size) return false;
+        return count <= (m_size - offset) / elem_size;
+    }
+
+    const char* m_data;
+    size_t m_size;
+    size_t m_count;
+    std::vector<CorpusFileTable> m_tables;
+    std::string m_processor;
+};
@@ -2,6 +2,8 @@
 #include "Python.h"
 #include <cstdint>
 #include <exception>
+#include <type_traits>
+#include <vector>
 #include <rapidfuzz/distance.hpp>
 #include <rapidfuzz/fuzz.hpp>
 
@@ -14,6 +16,8 @@
 #define RAPIDFUZZ_X64
 #endif
 
+#include "multi_long.hpp"
+
 namespace rf = rapidfuzz;
 namespace fuzz = rf::fuzz;
 using rf::detail::Range;
@@ -169,6 +173,58 @@ struct RF_StringWrapper {
     }
 };
 
+/**
+ * @brief bump allocator for the strings created while preprocessing a list of choices.
+ * The strings are placed back to back in large blocks, which are all freed together
+ * when the arena is destructed. So strings allocated from the arena do not set a dtor.
+ */
+class StringArena {
+public:
+    StringArena() : m_pos(nullptr), m_remaining(0), m_block_size(min_block_size)
+    {}
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    ~StringArena()
+    {
+        for (void* block : m_blocks)
+            free(block);
+    }
+
+    void* allocate(size_t size)
+    {
+        /* keep 8 byte alignment for hashed sequences. Empty strings still get a
+         * unique address, since a nullptr is used to mark None */
+        size = (std::max<size_t>(size, 1) + 7) & ~static_cast<size_t>(7);
+
+        if (size > m_remaining) {
+            size_t block_size = std::max(size, m_block_size);
+            char* block = static_cast<char*>(malloc(block_size));
+            if (block == nullptr) throw std::bad_alloc();
+
+            m_blocks.push_back(block);
+            m_pos = block;
+            m_remaining = block_size;
+            m_block_size = std::min(m_block_size * 2, max_block_size);
+        }
+
+        void* ptr = m_pos;
+        m_pos += size;
+        m_remaining -= size;
+        return ptr;
+    }
+
+private:
+    static constexpr size_t min_block_size = 64 * 1024;
+    static constexpr size_t max_block_size = 16 * 1024 * 1024;
+
+    std::vector<void*> m_blocks;
+    char* m_pos;
+    size_t m_remaining;
+    size_t m_block_size;
+};
+
 /* RAII Wrapper for RF_Kwargs */
 struct RF_KwargsWrapper {
     RF_Kwargs kwargs;
@@ -403,6 +459,62 @@ static inline bool normalized_similarity_func_wrapper(const RF_ScorerFunc* self,
     });
 }
 
+template <typename CachedScorer, typename T>
+static inline bool distance_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                               int64_t str_count, const T* score_cutoffs, T score_hint,
+                                               T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        for (int64_t i = 0; i < str_count; ++i)
+            result[i] = visit(str[i], [&](auto s) {
+                return scorer.distance(s, score_cutoffs[i], score_hint);
+            });
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool normalized_distance_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                                          int64_t str_count, const T* score_cutoffs,
+                                                          T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        for (int64_t i = 0; i < str_count; ++i)
+            result[i] = visit(str[i], [&](auto s) {
+                return scorer.normalized_distance(s, score_cutoffs[i], score_hint);
+            });
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool similarity_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                                 int64_t str_count, const T* score_cutoffs, T score_hint,
+                                                 T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        for (int64_t i = 0; i < str_count; ++i)
+            result[i] = visit(str[i], [&](auto s) {
+                return scorer.similarity(s, score_cutoffs[i], score_hint);
+            });
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool normalized_similarity_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                                            int64_t str_count, const T* score_cutoffs,
+                                                            T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        for (int64_t i = 0; i < str_count; ++i)
+            result[i] = visit(str[i], [&](auto s) {
+                return scorer.normalized_similarity(s, score_cutoffs[i], score_hint);
+            });
+    });
+}
+
 // todo cleanup
 typedef bool (*func_f64)(const struct _RF_ScorerFunc*, const RF_String*, int64_t, double, double, double*);
 typedef bool (*func_i64)(const struct _RF_ScorerFunc*, const RF_String*, int64_t, int64_t, int64_t, int64_t*);
@@ -417,6 +529,21 @@ static inline void assign_callback(RF_ScorerFunc& context, func_i64 func)
     context.call.i64 = func;
 }
 
+typedef bool (*batch_func_f64)(const struct _RF_ScorerFunc*, const RF_String*, int64_t, const double*, double,
+                               double*);
+typedef bool (*batch_func_i64)(const struct _RF_ScorerFunc*, const RF_String*, int64_t, const int64_t*,
+                               int64_t, int64_t*);
+
+static inline void assign_batch_callback(RF_ScorerFunc& context, batch_func_f64 func)
+{
+    context.call_batch.f64 = func;
+}
+
+static inline void assign_batch_callback(RF_ScorerFunc& context, batch_func_i64 func)
+{
+    context.call_batch.i64 = func;
+}
+
 template <template <typename> class CachedScorer, typename T, typename Sentence1, typename... Args>
 static inline RF_ScorerFunc get_ScorerContext(Sentence1 s1, Args... args)
 {
@@ -438,6 +565,7 @@ static inline bool distance_init(RF_ScorerFunc* self, int64_t str_count, const R
             using CharT1 = typename decltype(s)::value_type;
             RF_ScorerFunc context = get_ScorerContext<CachedScorer, T>(s, args...);
             assign_callback(context, distance_func_wrapper<CachedScorer<CharT1>, T>);
+            assign_batch_callback(context, distance_batch_func_wrapper<CachedScorer<CharT1>, T>);
             return context;
         });
     });
@@ -454,6 +582,7 @@ static inline bool normalized_distance_init(RF_ScorerFunc* self, int64_t str_cou
             using CharT1 = typename decltype(s)::value_type;
             RF_ScorerFunc context = get_ScorerContext<CachedScorer, T>(s, args...);
             assign_callback(context, normalized_distance_func_wrapper<CachedScorer<CharT1>, T>);
+            assign_batch_callback(context, normalized_distance_batch_func_wrapper<CachedScorer<CharT1>, T>);
             return context;
         });
     });
@@ -470,6 +599,7 @@ static inline bool similarity_init(RF_ScorerFunc* self, int64_t str_count, const
             using CharT1 = typename decltype(s)::value_type;
             RF_ScorerFunc context = get_ScorerContext<CachedScorer, T>(s, args...);
             assign_callback(context, similarity_func_wrapper<CachedScorer<CharT1>, T>);
+            assign_batch_callback(context, similarity_batch_func_wrapper<CachedScorer<CharT1>, T>);
             return context;
         });
     });
@@ -486,6 +616,7 @@ static inline bool normalized_similarity_init(RF_ScorerFunc* self, int64_t str_c
             using CharT1 = typename decltype(s)::value_type;
             RF_ScorerFunc context = get_ScorerContext<CachedScorer, T>(s, args...);
             assign_callback(context, normalized_similarity_func_wrapper<CachedScorer<CharT1>, T>);
+            assign_batch_callback(context, normalized_similarity_batch_func_wrapper<CachedScorer<CharT1>, T>);
             return context;
         });
     });
@@ -551,6 +682,76 @@ static inline bool multi_normalized_distance_func_wrapper(const RF_ScorerFunc* s
     });
 }
 
+template <typename CachedScorer, typename T>
+static inline bool multi_similarity_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                                       int64_t str_count, const T* score_cutoffs,
+                                                       [[maybe_unused]] T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        size_t result_count = scorer.result_count();
+        for (int64_t i = 0; i < str_count; ++i) {
+            T* scores = result + static_cast<size_t>(i) * result_count;
+            visit(str[i], [&](auto s) {
+                scorer.similarity(scores, result_count, s, score_cutoffs[i]);
+            });
+        }
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool multi_distance_batch_func_wrapper(const RF_ScorerFunc* self, const RF_String* str,
+                                                     int64_t str_count, const T* score_cutoffs,
+                                                     [[maybe_unused]] T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        size_t result_count = scorer.result_count();
+        for (int64_t i = 0; i < str_count; ++i) {
+            T* scores = result + static_cast<size_t>(i) * result_count;
+            visit(str[i], [&](auto s) {
+                scorer.distance(scores, result_count, s, score_cutoffs[i]);
+            });
+        }
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool multi_normalized_similarity_batch_func_wrapper(const RF_ScorerFunc* self,
+                                                                  const RF_String* str, int64_t str_count,
+                                                                  const T* score_cutoffs,
+                                                                  [[maybe_unused]] T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        size_t result_count = scorer.result_count();
+        for (int64_t i = 0; i < str_count; ++i) {
+            T* scores = result + static_cast<size_t>(i) * result_count;
+            visit(str[i], [&](auto s) {
+                scorer.normalized_similarity(scores, result_count, s, score_cutoffs[i]);
+            });
+        }
+    });
+}
+
+template <typename CachedScorer, typename T>
+static inline bool multi_normalized_distance_batch_func_wrapper(const RF_ScorerFunc* self,
+                                                                const RF_String* str, int64_t str_count,
+                                                                const T* score_cutoffs,
+                                                                [[maybe_unused]] T score_hint, T* result)
+{
+    return PyExceptionHandler([&] {
+        CachedScorer& scorer = *(CachedScorer*)self->context;
+        size_t result_count = scorer.result_count();
+        for (int64_t i = 0; i < str_count; ++i) {
+            T* scores = result + static_cast<size_t>(i) * result_count;
+            visit(str[i], [&](auto s) {
+                scorer.normalized_distance(scores, result_count, s, score_cutoffs[i]);
+            });
+        }
+    });
+}
+
 template <typename CachedScorer, typename T, typename... Args>
 static inline RF_ScorerFunc get_MultiScorerContext(int64_t str_count, const RF_String* strings, Args... args)
 {
@@ -573,6 +774,7 @@ static inline RF_ScorerFunc get_MultiScorerContext_similarity(int64_t str_count,
 {
     RF_ScorerFunc context = get_MultiScorerContext<CachedScorer, T>(str_count, strings, args...);
     assign_callback(context, multi_similarity_func_wrapper<CachedScorer, T>);
+    assign_batch_callback(context, multi_similarity_batch_func_wrapper<CachedScorer, T>);
     return context;
 }
 
@@ -582,6 +784,7 @@ static inline RF_ScorerFunc get_MultiScorerContext_distance(int64_t str_count, c
 {
     RF_ScorerFunc context = get_MultiScorerContext<CachedScorer, T>(str_count, strings, args...);
     assign_callback(context, multi_distance_func_wrapper<CachedScorer, T>);
+    assign_batch_callback(context, multi_distance_batch_func_wrapper<CachedScorer, T>);
     return context;
 }
 
@@ -591,6 +794,7 @@ get_MultiScorerContext_normalized_similarity(int64_t str_count, const RF_String*
 {
     RF_ScorerFunc context = get_MultiScorerContext<CachedScorer, T>(str_count, strings, args...);
     assign_callback(context, multi_normalized_similarity_func_wrapper<CachedScorer, T>);
+    assign_batch_callback(context, multi_normalized_similarity_batch_func_wrapper<CachedScorer, T>);
     return context;
 }
 
@@ -600,6 +804,7 @@ static inline RF_ScorerFunc get_MultiScorerContext_normalized_distance(int64_t s
 {
     RF_ScorerFunc context = get_MultiScorerContext<CachedScorer, T>(str_count, strings, args...);
     assign_callback(context, multi_normalized_distance_func_wrapper<CachedScorer, T>);
+    assign_batch_callback(context, multi_normalized_distance_batch_func_wrapper<CachedScorer, T>);
     return context;
 }
 
@@ -607,6 +812,7 @@ template <template <int> class CachedScorer, typename T, typename... Args>
 static inline bool multi_similarity_init(RF_ScorerFunc* self, int64_t str_count, const RF_String* strings,
                                          Args... args)
 {
+    using LongScorer = typename MultiScorerLong<CachedScorer>::type;
     return PyExceptionHandler([&] {
         int64_t length = 0;
         for (int64_t i = 0; i < str_count; ++i)
@@ -620,8 +826,12 @@ static inline bool multi_similarity_init(RF_ScorerFunc* self, int64_t str_count,
             *self = get_MultiScorerContext_similarity<CachedScorer<32>, T>(str_count, strings, args...);
         else if (length <= 64)
             *self = get_MultiScorerContext_similarity<CachedScorer<64>, T>(str_count, strings, args...);
-        else
-            throw std::runtime_error("invalid string length");
+        else {
+            if constexpr (std::is_void<LongScorer>::value)
+                throw std::runtime_error("invalid string length");
+            else
+                *self = get_MultiScorerContext_similarity<LongScorer, T>(str_count, strings, args...);
+        }
     });
 }
 
@@ -629,6 +839,7 @@ template <template <int> class CachedScorer, typename T, typename... Args>
 static inline bool multi_distance_init(RF_ScorerFunc* self, int64_t str_count, const RF_String* strings,
                                        Args... args)
 {
+    using LongScorer = typename MultiScorerLong<CachedScorer>::type;
     return PyExceptionHandler([&] {
         int64_t length = 0;
         for (int64_t i = 0; i < str_count; ++i)
@@ -642,8 +853,12 @@ static inline bool multi_distance_init(RF_ScorerFunc* self, int64_t str_count, c
             *self = get_MultiScorerContext_distance<CachedScorer<32>, T>(str_count, strings, args...);
         else if (length <= 64)
             *self = get_MultiScorerContext_distance<CachedScorer<64>, T>(str_count, strings, args...);
-        else
-            throw std::runtime_error("invalid string length");
+        else {
+            if constexpr (std::is_void<LongScorer>::value)
+                throw std::runtime_error("invalid string length");
+            else
+                *self = get_MultiScorerContext_distance<LongScorer, T>(str_count, strings, args...);
+        }
     });
 }
 
@@ -651,6 +866,7 @@ template <template <int> class CachedScorer, typename T, typename... Args>
 static inline bool multi_normalized_similarity_init(RF_ScorerFunc* self, int64_t str_count,
                                                     const RF_String* strings, Args... args)
 {
+    using LongScorer = typename MultiScorerLong<CachedScorer>::type;
     return PyExceptionHandler([&] {
         int64_t length = 0;
         for (int64_t i = 0; i < str_count; ++i)
@@ -668,8 +884,13 @@ static inline bool multi_normalized_similarity_init(RF_ScorerFunc* self, int64_t
         else if (length <= 64)
             *self = get_MultiScorerContext_normalized_similarity<CachedScorer<64>, T>(str_count, strings,
                                                                                       args...);
-        else
-            throw std::runtime_error("invalid string length");
+        else {
+            if constexpr (std::is_void<LongScorer>::value)
+                throw std::runtime_error("invalid string length");
+            else
+                *self =
+                    get_MultiScorerContext_normalized_similarity<LongScorer, T>(str_count, strings, args...);
+        }
     });
 }
 
@@ -677,6 +898,7 @@ template <template <int> class CachedScorer, typename T, typename... Args>
 static inline bool multi_normalized_distance_init(RF_ScorerFunc* self, int64_t str_count,
                                                   const RF_String* strings, Args... args)
 {
+    using LongScorer = typename MultiScorerLong<CachedScorer>::type;
     return PyExceptionHandler([&] {
         int64_t length = 0;
         for (int64_t i = 0; i < str_count; ++i)
@@ -694,8 +916,13 @@ static inline bool multi_normalized_distance_init(RF_ScorerFunc* self, int64_t s
         else if (length <= 64)
             *self =
                 get_MultiScorerContext_normalized_distance<CachedScorer<64>, T>(str_count, strings, args...);
-        else
-            throw std::runtime_error("invalid string length");
+        else {
+            if constexpr (std::is_void<LongScorer>::value)
+                throw std::runtime_error("invalid string length");
+            else
+                *self =
+                    get_MultiScorerContext_normalized_distance<LongScorer, T>(str_count, strings, args...);
+        }
     });
 }
 
@@ -229,6 +229,10 @@ cdef extern from "cpp_common.hpp":
         RF_StringWrapper(RF_String)
         RF_StringWrapper(RF_String, object)
 
+    cdef cppclass StringArena:
+        StringArena()
+        void* allocate(size_t) except +
+
     cdef cppclass RF_KwargsWrapper:
         RF_Kwargs kwargs
 
@@ -247,13 +251,16 @@ cdef extern from "cpp_common.hpp":
     RF_String convert_string(object py_str)
     void validate_string(object py_str, const char* err) except +
 
-cdef inline RF_String hash_array(arr) except *:
+cdef inline RF_String hash_array(arr, StringArena* arena=NULL) except *:
     # TODO on Cpython this does not require any copies
     cdef RF_String s_proc
     cdef Py_UCS4 typecode = <Py_UCS4>arr.typecode
     s_proc.length = <int64_t>len(arr)
 
-    s_proc.data = malloc(s_proc.length * sizeof(uint64_t))
+    if arena != NULL:
+        s_proc.data = arena.allocate(s_proc.length * sizeof(uint64_t))
+    else:
+        s_proc.data = malloc(s_proc.length * sizeof(uint64_t))
 
     if s_proc.data == NULL:
         raise MemoryError
@@ -289,19 +296,27 @@ cdef inline RF_String hash_array(arr) except *:
             for i in range(s_proc.length):
                 (<uint64_t*>s_proc.data)[i] = <uint64_t>hash(arr[i])
     except Exception as e:
-        free(s_proc.data)
+        if arena == NULL:
+            free(s_proc.data)
         s_proc.data = NULL
         raise
 
-    s_proc.dtor = default_string_deinit
+    # the memory is owned by the arena
+    if arena == NULL:
+        s_proc.dtor = default_string_deinit
+    else:
+        s_proc.dtor = NULL
     return s_proc
 
 
-cdef inline RF_String hash_sequence(seq) except *:
+cdef inline RF_String hash_sequence(seq, StringArena* arena=NULL) except *:
     cdef RF_String s_proc
     s_proc.length = <int64_t>len(seq)
 
-    s_proc.data = malloc(s_proc.length * sizeof(uint64_t))
+    if arena != NULL:
+        s_proc.data = arena.allocate(s_proc.length * sizeof(uint64_t))
+    else:
+        s_proc.data = malloc(s_proc.length * sizeof(uint64_t))
 
     if s_proc.data == NULL:
         raise MemoryError
@@ -318,20 +333,25 @@ cdef inline RF_String hash_sequence(seq) except *:
             else:
                 (<uint64_t*>s_proc.data)[i] = <uint64_t>hash(elem)
     except Exception as e:
-        free(s_proc.data)
+        if arena == NULL:
+            free(s_proc.data)
         s_proc.data = NULL
         raise
 
-    s_proc.dtor = default_string_deinit
+    # the memory is owned by the arena
+    if arena == NULL:
+        s_proc.dtor = default_string_deinit
+    else:
+        s_proc.dtor = NULL
     return s_proc
 
-cdef inline RF_String conv_sequence(seq) except *:
+cdef inline RF_String conv_sequence(seq, StringArena* arena=NULL) except *:
     if is_valid_string(seq):
         return move(convert_string(seq))
     elif isinstance(seq, array):
-        return move(hash_array(seq))
+        return move(hash_array(seq, arena))
     else:
-        return move(hash_sequence(seq))
+        return move(hash_sequence(seq, arena))
 
 cdef inline double get_score_cutoff_f64(score_cutoff, const RF_ScorerFlags* scorer_flags) except *:
     cdef float worst_score = scorer_flags.worst_score.f64
@@ -5,11 +5,15 @@ from . import metrics_py
 from ._initialize_cpp import Editops
 
 from rapidfuzz cimport (
+    RF_SCORER_FLAG_LCS_BOUND,
+    RF_SCORER_FLAG_LENGTH_BOUND,
     RF_SCORER_FLAG_MULTI_STRING_CALL,
     RF_SCORER_FLAG_MULTI_STRING_INIT,
+    RF_SCORER_FLAG_MULTI_STRING_LONG,
     RF_SCORER_FLAG_RESULT_F64,
     RF_SCORER_FLAG_RESULT_I64,
     RF_SCORER_FLAG_SYMMETRIC,
+    RF_SCORER_FLAG_TRIANGLE_INEQUALITY,
     RF_SCORER_NONE_IS_WORST_SCORE,
     RF_Kwargs,
     RF_Preprocess,
@@ -313,11 +317,11 @@ cdef bool LevenshteinKwargsInit(RF_Kwargs* self, dict kwargs) except False:
 
 cdef bool GetScorerFlagsLevenshteinDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     cdef LevenshteinWeightTable* weights = <LevenshteinWeightTable*>self.context
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if weights.insert_cost == weights.delete_cost:
-        scorer_flags.flags |= RF_SCORER_FLAG_SYMMETRIC
+        scorer_flags.flags |= RF_SCORER_FLAG_TRIANGLE_INEQUALITY
     if LevenshteinMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
@@ -325,11 +329,11 @@ cdef bool GetScorerFlagsLevenshteinDistance(const RF_Kwargs* self, RF_ScorerFlag
 
 cdef bool GetScorerFlagsLevenshteinSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     cdef LevenshteinWeightTable* weights = <LevenshteinWeightTable*>self.context
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if weights.insert_cost == weights.delete_cost:
         scorer_flags.flags |= RF_SCORER_FLAG_SYMMETRIC
     if LevenshteinMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
@@ -337,11 +341,11 @@ cdef bool GetScorerFlagsLevenshteinSimilarity(const RF_Kwargs* self, RF_ScorerFl
 
 cdef bool GetScorerFlagsLevenshteinNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     cdef LevenshteinWeightTable* weights = <LevenshteinWeightTable*>self.context
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if weights.insert_cost == weights.delete_cost:
         scorer_flags.flags |= RF_SCORER_FLAG_SYMMETRIC
     if LevenshteinMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 0
     scorer_flags.worst_score.f64 = 1.0
@@ -349,11 +353,11 @@ cdef bool GetScorerFlagsLevenshteinNormalizedDistance(const RF_Kwargs* self, RF_
 
 cdef bool GetScorerFlagsLevenshteinNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     cdef LevenshteinWeightTable* weights = <LevenshteinWeightTable*>self.context
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if weights.insert_cost == weights.delete_cost:
         scorer_flags.flags |= RF_SCORER_FLAG_SYMMETRIC
     if LevenshteinMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
@@ -408,25 +412,25 @@ def damerau_levenshtein_normalized_similarity(s1, s2, *, processor=None, score_c
     return damerau_levenshtein_normalized_similarity_func(s1_proc.string, s2_proc.string, c_score_cutoff)
 
 cdef bool GetScorerFlagsDamerauLevenshteinDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_TRIANGLE_INEQUALITY | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
     return True
 
 cdef bool GetScorerFlagsDamerauLevenshteinNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1
     return True
 
 cdef bool GetScorerFlagsDamerauLevenshteinSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
     return True
 
 cdef bool GetScorerFlagsDamerauLevenshteinNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
     return True
@@ -497,36 +501,36 @@ def lcs_seq_opcodes(s1, s2, *, processor=None):
 
 
 cdef bool GetScorerFlagsLCSseqDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if LCSseqMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
     return True
 
 cdef bool GetScorerFlagsLCSseqNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if LCSseqMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1
     return True
 
 cdef bool GetScorerFlagsLCSseqSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if LCSseqMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
     return True
 
 cdef bool GetScorerFlagsLCSseqNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if LCSseqMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
@@ -600,9 +604,9 @@ def indel_opcodes(s1, s2, *, processor=None):
 
 
 cdef bool GetScorerFlagsIndelDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_TRIANGLE_INEQUALITY | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if IndelMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
@@ -610,18 +614,18 @@ cdef bool GetScorerFlagsIndelDistance(const RF_Kwargs* self, RF_ScorerFlags* sco
 
 
 cdef bool GetScorerFlagsIndelNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if IndelMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1
     return True
 
 cdef bool GetScorerFlagsIndelSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if IndelMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
@@ -629,9 +633,9 @@ cdef bool GetScorerFlagsIndelSimilarity(const RF_Kwargs* self, RF_ScorerFlags* s
 
 
 cdef bool GetScorerFlagsIndelNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if IndelMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
@@ -717,24 +721,33 @@ cdef bool HammingKwargsInit(RF_Kwargs* self, dict kwargs) except False:
 
 cdef bool GetScorerFlagsHammingDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    # without padding strings of a different length are rejected
+    if (<bool*>self.context)[0]:
+        scorer_flags.flags |= RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND | RF_SCORER_FLAG_TRIANGLE_INEQUALITY
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
     return True
 
 cdef bool GetScorerFlagsHammingNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    if (<bool*>self.context)[0]:
+        scorer_flags.flags |= RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1.0
     return True
 
 cdef bool GetScorerFlagsHammingSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    if (<bool*>self.context)[0]:
+        scorer_flags.flags |= RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
     return True
 
 cdef bool GetScorerFlagsHammingNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    if (<bool*>self.context)[0]:
+        scorer_flags.flags |= RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
     return True
@@ -789,36 +802,36 @@ def osa_normalized_similarity(s1, s2, *, processor=None, score_cutoff=None):
 
 
 cdef bool GetScorerFlagsOSADistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if OSAMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
     return True
 
 cdef bool GetScorerFlagsOSANormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if OSAMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1.0
     return True
 
 cdef bool GetScorerFlagsOSASimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if OSAMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
     return True
 
 cdef bool GetScorerFlagsOSANormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
     if OSAMultiStringSupport(self):
-        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT | RF_SCORER_FLAG_MULTI_STRING_LONG
 
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
@@ -1082,25 +1095,25 @@ def prefix_normalized_similarity(s1, s2, *, processor=None, score_cutoff=None):
 
 
 cdef bool GetScorerFlagsPrefixDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND
     scorer_flags.optimal_score.i64 = 0
     scorer_flags.worst_score.i64 = INT64_MAX
     return True
 
 cdef bool GetScorerFlagsPrefixNormalizedDistance(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND
     scorer_flags.optimal_score.f64 = 0.0
     scorer_flags.worst_score.f64 = 1.0
     return True
 
 cdef bool GetScorerFlagsPrefixSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_I64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_FLAG_LENGTH_BOUND
     scorer_flags.optimal_score.i64 = INT64_MAX
     scorer_flags.worst_score.i64 = 0
     return True
 
 cdef bool GetScorerFlagsPrefixNormalizedSimilarity(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
-    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND
     scorer_flags.optimal_score.f64 = 1.0
     scorer_flags.worst_score.f64 = 0
     return True
@@ -0,0 +1,5 @@
+# distutils: language=c++
+# cython: language_level=3, binding=True, linetrace=True
+
+# this is a hack since I could not get this to build in cmake without it
+include "metrics_cpp.pyx"
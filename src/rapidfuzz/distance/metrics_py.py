@@ -10,6 +10,7 @@ from rapidfuzz._utils import default_distance_attribute as dist_attr
 from rapidfuzz._utils import default_normalized_distance_attribute as norm_dist_attr
 from rapidfuzz._utils import default_normalized_similarity_attribute as norm_sim_attr
 from rapidfuzz._utils import default_similarity_attribute as sim_attr
+from rapidfuzz._utils import metric_distance_attribute as metric_dist_attr
 
 # DamerauLevenshtein
 from rapidfuzz.distance.DamerauLevenshtein_py import (
@@ -182,7 +183,7 @@ __all__ += [
 ]
 
 
-add_scorer_attrs(damerau_levenshtein_distance, dist_attr)
+add_scorer_attrs(damerau_levenshtein_distance, metric_dist_attr)
 add_scorer_attrs(damerau_levenshtein_similarity, sim_attr)
 add_scorer_attrs(damerau_levenshtein_normalized_distance, norm_dist_attr)
 add_scorer_attrs(damerau_levenshtein_normalized_similarity, norm_sim_attr)
@@ -198,7 +199,7 @@ __all__ += [
 def _get_scorer_flags_levenshtein_distance(weights: tuple[int, int, int] | None = (1, 1, 1)) -> dict[str, Any]:
     flags = ScorerFlag.RESULT_I64
     if weights is None or weights[0] == weights[1]:
-        flags |= ScorerFlag.SYMMETRIC
+        flags |= ScorerFlag.TRIANGLE_INEQUALITY
 
     return {
         "optimal_score": 0,
@@ -282,7 +283,7 @@ __all__ += [
 ]
 
 
-add_scorer_attrs(indel_distance, dist_attr)
+add_scorer_attrs(indel_distance, metric_dist_attr)
 add_scorer_attrs(indel_similarity, sim_attr)
 add_scorer_attrs(indel_normalized_distance, norm_dist_attr)
 add_scorer_attrs(indel_normalized_similarity, norm_sim_attr)
@@ -297,7 +298,22 @@ __all__ += [
 ]
 
 
-add_scorer_attrs(hamming_distance, dist_attr)
+def _get_scorer_flags_hamming_distance(pad: bool = True) -> dict[str, Any]:
+    flags = ScorerFlag.RESULT_I64 | ScorerFlag.SYMMETRIC
+    # without padding strings of a different length are rejected
+    if pad:
+        flags |= ScorerFlag.TRIANGLE_INEQUALITY
+
+    return {
+        "optimal_score": 0,
+        "worst_score": 2**63 - 1,
+        "flags": flags,
+    }
+
+
+hamming_dist_attr: dict[str, Callable[..., dict[str, Any]]] = {"get_scorer_flags": _get_scorer_flags_hamming_distance}
+
+add_scorer_attrs(hamming_distance, hamming_dist_attr)
 add_scorer_attrs(hamming_similarity, sim_attr)
 add_scorer_attrs(hamming_normalized_distance, norm_dist_attr)
 add_scorer_attrs(hamming_normalized_similarity, norm_sim_attr)
@@ -5,6 +5,8 @@ from . import fuzz_py
 from .distance._initialize_cpp import ScoreAlignment
 
 from rapidfuzz cimport (
+    RF_SCORER_FLAG_LCS_BOUND,
+    RF_SCORER_FLAG_LENGTH_BOUND,
     RF_SCORER_FLAG_MULTI_STRING_INIT,
     RF_SCORER_FLAG_RESULT_F64,
     RF_SCORER_FLAG_SYMMETRIC,
@@ -203,6 +205,15 @@ cdef bool GetScorerFlagsFuzz(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags
     return True
 
 cdef bool GetScorerFlagsFuzzRatio(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
+    scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE | RF_SCORER_FLAG_LENGTH_BOUND | RF_SCORER_FLAG_LCS_BOUND
+    if RatioMultiStringSupport(self):
+        scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
+
+    scorer_flags.optimal_score.f64 = 100
+    scorer_flags.worst_score.f64 = 0
+    return True
+
+cdef bool GetScorerFlagsFuzzTokenSortRatio(const RF_Kwargs* self, RF_ScorerFlags* scorer_flags) except False nogil:
     scorer_flags.flags = RF_SCORER_FLAG_RESULT_F64 | RF_SCORER_FLAG_SYMMETRIC | RF_SCORER_NONE_IS_WORST_SCORE
     if RatioMultiStringSupport(self):
         scorer_flags.flags |= RF_SCORER_FLAG_MULTI_STRING_INIT
@@ -217,7 +228,7 @@ SetScorerAttrs(ratio, fuzz_py.ratio, &RatioContext)
 cdef RF_Scorer PartialRatioContext = CreateScorerContext(NoKwargsInit, GetScorerFlagsFuzz, PartialRatioInit)
 SetScorerAttrs(partial_ratio, fuzz_py.partial_ratio, &PartialRatioContext)
 
-cdef RF_Scorer TokenSortRatioContext = CreateScorerContext(NoKwargsInit, GetScorerFlagsFuzzRatio, TokenSortRatioInit)
+cdef RF_Scorer TokenSortRatioContext = CreateScorerContext(NoKwargsInit, GetScorerFlagsFuzzTokenSortRatio, TokenSortRatioInit)
 SetScorerAttrs(token_sort_ratio, fuzz_py.token_sort_ratio, &TokenSortRatioContext)
 
 cdef RF_Scorer TokenSetRatioContext = CreateScorerContext(NoKwargsInit, GetScorerFlagsFuzz, TokenSetRatioInit)
@@ -9,12 +9,18 @@ generate_cython()
 
 generate_cython fuzz_cpp
 generate_cython fuzz_cpp_avx2
+generate_cython fuzz_cpp_avx512
 generate_cython fuzz_cpp_sse2
 generate_cython process_cpp_impl
+generate_cython process_cpp_impl_avx2
+generate_cython process_cpp_impl_avx512
 generate_cython utils_cpp
+generate_cython utils_cpp_avx2
+generate_cython utils_cpp_sse2
 generate_cython _feature_detector_cpp
 
 generate_cython distance/_initialize_cpp
 generate_cython distance/metrics_cpp
 generate_cython distance/metrics_cpp_avx2
+generate_cython distance/metrics_cpp_avx512
 generate_cython distance/metrics_cpp_sse2
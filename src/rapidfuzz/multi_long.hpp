@@ -0,0 +1,484 @@
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <rapidfuzz/distance.hpp>
+
+/*
+ * Bit-parallel multi string scorers for strings longer than 64 characters.
+ *
+ * The multi string scorers of rapidfuzz-cpp store each string in a single SIMD lane and
+ * are therefore limited to 64 characters. The scorers in here store each string in a lane
+ * made up of several 64 bit words instead. The words of all lanes are interleaved, so
+ * the innermost loops run over independent lanes and can be vectorized by the compiler,
+ * while the carries between the words of a lane are propagated in order.
+ */
+namespace multi_long {
+
+template <typename Derived>
+class MultiScorerLongBase {
+public:
+    explicit MultiScorerLongBase(size_t str_count)
+    {
+        m_lens.reserve(str_count);
+    }
+
+    template <typename Range>
+    void insert(const Range& s)
+    {
+        m_lens.push_back(static_cast<int64_t>(s.size()));
+        for (auto ch : s)
+            m_chars.push_back(static_cast<uint64_t>(ch));
+
+        m_prepared = false;
+    }
+
+    size_t result_count() const
+    {
+        return m_lens.size();
+    }
+
+    template <typename Range>
+    void distance(int64_t* scores, size_t score_count, const Range& s2,
+                  int64_t score_cutoff = std::numeric_limits<int64_t>::max())
+    {
+        compute(score_count, s2);
+        for (size_t i = 0; i < m_lens.size(); ++i)
+            scores[i] = (m_dist[i] <= score_cutoff) ? m_dist[i] : score_cutoff + 1;
+    }
+
+    template <typename Range>
+    void similarity(int64_t* scores, size_t score_count, const Range& s2, int64_t score_cutoff = 0)
+    {
+        compute(score_count, s2);
+        int64_t len2 = static_cast<int64_t>(s2.size());
+        for (size_t i = 0; i < m_lens.size(); ++i) {
+            int64_t sim = Derived::maximum(m_lens[i], len2) - m_dist[i];
+            scores[i] = (sim >= score_cutoff) ? sim : 0;
+        }
+    }
+
+    template <typename Range>
+    void normalized_distance(double* scores, size_t score_count, const Range& s2, double score_cutoff = 1.0)
+    {
+        compute(score_count, s2);
+        int64_t len2 = static_cast<int64_t>(s2.size());
+        for (size_t i = 0; i < m_lens.size(); ++i) {
+            double norm_dist = norm_distance(m_lens[i], len2, m_dist[i]);
+            scores[i] = (norm_dist <= score_cutoff) ? norm_dist : 1.0;
+        }
+    }
+
+    template <typename Range>
+    void normalized_similarity(double* scores, size_t score_count, const Range& s2, double score_cutoff = 0.0)
+    {
+        compute(score_count, s2);
+        int64_t len2 = static_cast<int64_t>(s2.size());
+        for (size_t i = 0; i < m_lens.size(); ++i) {
+            double norm_sim = 1.0 - norm_distance(m_lens[i], len2, m_dist[i]);
+            scores[i] = (norm_sim >= score_cutoff) ? norm_sim : 0.0;
+        }
+    }
+
+protected:
+    /* lanes processed together, so their state fits into registers */
+    static constexpr size_t lane_group = 8;
+
+    /* number of strings and 64 bit words per string */
+    size_t m_lanes = 0;
+    size_t m_words = 0;
+    std::vector<int64_t> m_lens;
+    /* bit of the last character of each lane, stored for the word it is placed in */
+    std::vector<uint64_t> m_last;
+    /* distance of each lane to the current string */
+    std::vector<int64_t> m_dist;
+
+    /* pattern match vectors of all lanes for a character, indexed as [word * m_lanes + lane] */
+    const uint64_t* pattern(uint64_t ch) const
+    {
+        size_t row = 0;
+        if (ch < 256) {
+            row = m_ascii_rows[ch];
+        }
+        else {
+            auto it = m_extended_rows.find(ch);
+            if (it != m_extended_rows.end()) row = it->second;
+        }
+        return &m_PM[row * m_words * m_lanes];
+    }
+
+private:
+    bool m_prepared = false;
+    std::vector<uint64_t> m_chars;
+    /* row 0 of the pattern match table is all zero and used for unknown characters */
+    std::vector<uint64_t> m_PM;
+    std::vector<size_t> m_ascii_rows;
+    std::unordered_map<uint64_t, size_t> m_extended_rows;
+
+    static double norm_distance(int64_t len1, int64_t len2, int64_t dist)
+    {
+        int64_t maximum = Derived::maximum(len1, len2);
+        return maximum ? static_cast<double>(dist) / static_cast<double>(maximum) : 0.0;
+    }
+
+    size_t row_for(uint64_t ch)
+    {
+        size_t* row = nullptr;
+        if (ch < 256)
+            row = &m_ascii_rows[ch];
+        else
+            row = &m_extended_rows[ch];
+
+        if (!*row) {
+            *row = m_PM.size() / (m_words * m_lanes);
+            m_PM.resize(m_PM.size() + m_words * m_lanes, 0);
+        }
+        return *row;
+    }
+
+    /* the pattern match table is built once all strings are inserted */
+    void prepare()
+    {
+        int64_t max_len = 0;
+        for (int64_t len : m_lens)
+            max_len = std::max(max_len, len);
+
+        /* the lanes are padded to full groups, so the loops over a group have a fixed length */
+        m_lanes = (m_lens.size() + lane_group - 1) / lane_group * lane_group;
+        m_words = std::max<size_t>(1, (static_cast<size_t>(max_len) + 63) / 64);
+        m_PM.assign(m_words * m_lanes, 0);
+        m_ascii_rows.assign(256, 0);
+        m_extended_rows.clear();
+        m_last.assign(m_words * m_lanes, 0);
+        m_dist.resize(m_lens.size());
+
+        size_t pos = 0;
+        for (size_t lane = 0; lane < m_lens.size(); ++lane) {
+            size_t len = static_cast<size_t>(m_lens[lane]);
+            for (size_t i = 0; i < len; ++i) {
+                size_t row = row_for(m_chars[pos + i]);
+                m_PM[(row * m_words + i / 64) * m_lanes + lane] |= UINT64_C(1) << (i % 64);
+            }
+            if (len) m_last[((len - 1) / 64) * m_lanes + lane] = UINT64_C(1) << ((len - 1) % 64);
+            pos += len;
+        }
+
+        m_prepared = true;
+    }
+
+    template <typename Range>
+    void compute(size_t score_count, const Range& s2)
+    {
+        if (score_count < result_count())
+            throw std::invalid_argument("scores has to have >= result_count() elements");
+
+        if (!m_prepared) prepare();
+        static_cast<Derived*>(this)->_distance(s2);
+    }
+};
+
+/**
+ * @brief Levenshtein distance with uniform weights based on the blockwise
+ * bit-parallel algorithm by Hyyrö
+ */
+class MultiLevenshteinLong : public MultiScorerLongBase<MultiLevenshteinLong> {
+    friend class MultiScorerLongBase<MultiLevenshteinLong>;
+
+public:
+    using MultiScorerLongBase::MultiScorerLongBase;
+
+private:
+    struct Vectors {
+        uint64_t VP;
+        uint64_t VN;
+    };
+    std::vector<Vectors> m_vecs;
+
+    static int64_t maximum(int64_t len1, int64_t len2)
+    {
+        return std::max(len1, len2);
+    }
+
+    template <typename Range>
+    void _distance(const Range& s2)
+    {
+        size_t lanes = m_lanes;
+        m_vecs.assign(m_words * lanes, {~UINT64_C(0), 0});
+        Vectors* vecs = m_vecs.data();
+        const uint64_t* last = m_last.data();
+
+        for (size_t group = 0; group < lanes; group += lane_group) {
+            size_t group_size = std::min(lane_group, m_lens.size() - group);
+            int64_t dist[lane_group];
+            uint64_t HP_carry[lane_group];
+            uint64_t HN_carry[lane_group];
+
+            std::fill(dist, dist + lane_group, 0);
+            for (size_t lane = 0; lane < group_size; ++lane)
+                dist[lane] = m_lens[group + lane];
+
+            for (auto ch : s2) {
+                const uint64_t* PM = pattern(static_cast<uint64_t>(ch));
+                std::fill(HP_carry, HP_carry + lane_group, 1);
+                std::fill(HN_carry, HN_carry + lane_group, 0);
+
+                for (size_t word = 0; word < m_words; ++word) {
+                    size_t offset = word * lanes + group;
+                    for (size_t lane = 0; lane < lane_group; ++lane) {
+                        size_t i = offset + lane;
+                        uint64_t VP = vecs[i].VP;
+                        uint64_t VN = vecs[i].VN;
+
+                        uint64_t X = PM[i] | HN_carry[lane];
+                        uint64_t D0 = (((X & VP) + VP) ^ VP) | X | VN;
+                        uint64_t HP = VN | ~(D0 | VP);
+                        uint64_t HN = D0 & VP;
+
+                        dist[lane] += static_cast<int64_t>((HP & last[i]) != 0);
+                        dist[lane] -= static_cast<int64_t>((HN & last[i]) != 0);
+
+                        uint64_t HP_carry_temp = HP_carry[lane];
+                        uint64_t HN_carry_temp = HN_carry[lane];
+                        HP_carry[lane] = HP >> 63;
+                        HN_carry[lane] = HN >> 63;
+                        HP = (HP << 1) | HP_carry_temp;
+                        HN = (HN << 1) | HN_carry_temp;
+
+                        vecs[i].VP = HN | ~(D0 | HP);
+                        vecs[i].VN = HP & D0;
+                    }
+                }
+            }
+
+            for (size_t lane = 0; lane < group_size; ++lane)
+                m_dist[group + lane] = m_lens[group + lane] ? dist[lane] : static_cast<int64_t>(s2.size());
+        }
+    }
+};
+
+/**
+ * @brief Optimal String Alignment distance based on the bit-parallel algorithm by Hyyrö,
+ * which extends the Levenshtein algorithm with transpositions
+ */
+class MultiOSALong : public MultiScorerLongBase<MultiOSALong> {
+    friend class MultiScorerLongBase<MultiOSALong>;
+
+public:
+    using MultiScorerLongBase::MultiScorerLongBase;
+
+private:
+    struct Vectors {
+        uint64_t VP;
+        uint64_t VN;
+        uint64_t D0;
+        uint64_t PM;
+    };
+    std::vector<Vectors> m_vecs;
+
+    static int64_t maximum(int64_t len1, int64_t len2)
+    {
+        return std::max(len1, len2);
+    }
+
+    template <typename Range>
+    void _distance(const Range& s2)
+    {
+        size_t lanes = m_lanes;
+        m_vecs.assign(m_words * lanes, {~UINT64_C(0), 0, 0, 0});
+        Vectors* vecs = m_vecs.data();
+        const uint64_t* last = m_last.data();
+
+        for (size_t group = 0; group < lanes; group += lane_group) {
+            size_t group_size = std::min(lane_group, m_lens.size() - group);
+            int64_t dist[lane_group];
+            uint64_t HP_carry[lane_group];
+            uint64_t HN_carry[lane_group];
+            uint64_t TR_carry[lane_group];
+
+            std::fill(dist, dist + lane_group, 0);
+            for (size_t lane = 0; lane < group_size; ++lane)
+                dist[lane] = m_lens[group + lane];
+
+            for (auto ch : s2) {
+                const uint64_t* PM = pattern(static_cast<uint64_t>(ch));
+                std::fill(HP_carry, HP_carry + lane_group, 1);
+                std::fill(HN_carry, HN_carry + lane_group, 0);
+                std::fill(TR_carry, TR_carry + lane_group, 0);
+
+                for (size_t word = 0; word < m_words; ++word) {
+                    size_t offset = word * lanes + group;
+                    for (size_t lane = 0; lane < lane_group; ++lane) {
+                        size_t i = offset + lane;
+                        uint64_t VP = vecs[i].VP;
+                        uint64_t VN = vecs[i].VN;
+                        uint64_t PM_j = PM[i];
+
+                        /* transpositions use D0 of the last character, which is shifted across words */
+                        uint64_t TR_base = ~vecs[i].D0 & PM_j;
+                        uint64_t TR = ((TR_base << 1) | TR_carry[lane]) & vecs[i].PM;
+                        TR_carry[lane] = TR_base >> 63;
+
+                        uint64_t X = PM_j | HN_carry[lane];
+                        uint64_t D0 = (((X & VP) + VP) ^ VP) | X | VN | TR;
+                        uint64_t HP = VN | ~(D0 | VP);
+                        uint64_t HN = D0 & VP;
+
+                        dist[lane] += static_cast<int64_t>((HP & last[i]) != 0);
+                        dist[lane] -= static_cast<int64_t>((HN & last[i]) != 0);
+
+                        uint64_t HP_carry_temp = HP_carry[lane];
+                        uint64_t HN_carry_temp = HN_carry[lane];
+                        HP_carry[lane] = HP >> 63;
+                        HN_carry[lane] = HN >> 63;
+                        HP = (HP << 1) | HP_carry_temp;
+                        HN = (HN << 1) | HN_carry_temp;
+
+                        vecs[i].VP = HN | ~(D0 | HP);
+                        vecs[i].VN = HP & D0;
+                        vecs[i].D0 = D0;
+                        vecs[i].PM = PM_j;
+                    }
+                }
+            }
+
+            for (size_t lane = 0; lane < group_size; ++lane)
+                m_dist[group + lane] = m_lens[group + lane] ? dist[lane] : static_cast<int64_t>(s2.size());
+        }
+    }
+};
+
+/**
+ * @brief longest common subsequence based on the bit-parallel algorithm by Hyyrö.
+ * The distance is calculated from the similarity by the derived classes.
+ */
+template <typename Derived>
+class MultiLCSLongBase : public MultiScorerLongBase<Derived> {
+    friend class MultiScorerLongBase<Derived>;
+
+public:
+    using MultiScorerLongBase<Derived>::MultiScorerLongBase;
+
+private:
+    std::vector<uint64_t> m_S;
+
+    template <typename Range>
+    void _distance(const Range& s2)
+    {
+        constexpr size_t lane_group = MultiScorerLongBase<Derived>::lane_group;
+        size_t lanes = this->m_lanes;
+        size_t words = this->m_words;
+        m_S.assign(words * lanes, ~UINT64_C(0));
+        uint64_t* S_ = m_S.data();
+
+        for (size_t group = 0; group < lanes; group += lane_group) {
+            uint64_t carry[lane_group];
+
+            for (auto ch : s2) {
+                const uint64_t* PM = this->pattern(static_cast<uint64_t>(ch));
+                std::fill(carry, carry + lane_group, 0);
+
+                for (size_t word = 0; word < words; ++word) {
+                    uint64_t* S_word = S_ + word * lanes + group;
+                    const uint64_t* PM_word = PM + word * lanes + group;
+                    for (size_t lane = 0; lane < lane_group; ++lane) {
+                        uint64_t S = S_word[lane];
+                        uint64_t u = S & PM_word[lane];
+
+                        uint64_t x = S + u + carry[lane];
+                        carry[lane] = ((S & u) | ((S | u) & ~x)) >> 63;
+
+                        S_word[lane] = x | (S - u);
+                    }
+                }
+            }
+        }
+
+        int64_t len2 = static_cast<int64_t>(s2.size());
+        for (size_t lane = 0; lane < this->m_lens.size(); ++lane) {
+            int64_t lcs = 0;
+            for (size_t word = 0; word < words; ++word)
+                lcs += static_cast<int64_t>(std::bitset<64>(~S_[word * lanes + lane]).count());
+
+            this->m_dist[lane] = Derived::lcs_to_distance(this->m_lens[lane], len2, lcs);
+        }
+    }
+};
+
+class MultiIndelLong : public MultiLCSLongBase<MultiIndelLong> {
+    friend class MultiScorerLongBase<MultiIndelLong>;
+    friend class MultiLCSLongBase<MultiIndelLong>;
+
+public:
+    using MultiLCSLongBase::MultiLCSLongBase;
+
+private:
+    static int64_t maximum(int64_t len1, int64_t len2)
+    {
+        return len1 + len2;
+    }
+
+    static int64_t lcs_to_distance(int64_t len1, int64_t len2, int64_t lcs)
+    {
+        return len1 + len2 - 2 * lcs;
+    }
+};
+
+class MultiLCSseqLong : public MultiLCSLongBase<MultiLCSseqLong> {
+    friend class MultiScorerLongBase<MultiLCSseqLong>;
+    friend class MultiLCSLongBase<MultiLCSseqLong>;
+
+public:
+    using MultiLCSLongBase::MultiLCSLongBase;
+
+private:
+    static int64_t maximum(int64_t len1, int64_t len2)
+    {
+        return std::max(len1, len2);
+    }
+
+    static int64_t lcs_to_distance(int64_t len1, int64_t len2, int64_t lcs)
+    {
+        return std::max(len1, len2) - lcs;
+    }
+};
+
+} // namespace multi_long
+
+/**
+ * @brief multi string scorer used for strings, which are too long for the multi string
+ * scorer passed to multi_*_init. Specialized for every multi string scorer with a long
+ * string counterpart. `type` is void for all other scorers, which reject these strings.
+ * Scorers using a specialization set RF_SCORER_FLAG_MULTI_STRING_LONG.
+ */
+template <template <int> class CachedScorer>
+struct MultiScorerLong {
+    using type = void;
+};
+
+#ifdef RAPIDFUZZ_X64
+template <>
+struct MultiScorerLong<rapidfuzz::experimental::MultiLevenshtein> {
+    using type = multi_long::MultiLevenshteinLong;
+};
+
+template <>
+struct MultiScorerLong<rapidfuzz::experimental::MultiOSA> {
+    using type = multi_long::MultiOSALong;
+};
+
+template <>
+struct MultiScorerLong<rapidfuzz::experimental::MultiIndel> {
+    using type = multi_long::MultiIndelLong;
+};
+
+template <>
+struct MultiScorerLong<rapidfuzz::experimental::MultiLCSseq> {
+    using type = multi_long::MultiLCSseqLong;
+};
+#endif
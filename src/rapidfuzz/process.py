@@ -10,3 +10,6 @@ extract = _fallback_import(_mod, "extract")
 extractOne = _fallback_import(_mod, "extractOne")
 extract_iter = _fallback_import(_mod, "extract_iter")
 cdist = _fallback_import(_mod, "cdist")
+cdist_sparse = _fallback_import(_mod, "cdist_sparse")
+cdist_topk = _fallback_import(_mod, "cdist_topk")
+Corpus = _fallback_import(_mod, "Corpus")
@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+from os import PathLike
 from typing import (
     Any,
     Callable,
@@ -20,6 +21,33 @@ _S1 = TypeVar("_S1")
 _S2 = TypeVar("_S2")
 _ResultType = int | float
 
+class Corpus:
+    choices: list[Any]
+    keys: list[Any] | None
+    processor: Callable[..., _StringType] | None
+    qgram_size: int | None
+    def __init__(
+        self,
+        choices: Iterable[_StringType | None] | Mapping[Any, _StringType | None],
+        *,
+        processor: Callable[..., _StringType] | None = None,
+        qgram_size: int | None = None,
+        workers: int = 1,
+    ) -> None: ...
+    def __len__(self) -> int: ...
+    def build_bktree(
+        self, scorer: Callable[..., int], *, scorer_kwargs: dict[str, Any] | None = None
+    ) -> None: ...
+    def save(self, path: str | PathLike[str]) -> None: ...
+    @classmethod
+    def load(
+        cls,
+        path: str | PathLike[str],
+        *,
+        processor: Callable[..., _StringType] | None = None,
+        qgram_size: int | None = None,
+    ) -> Corpus: ...
+
 @overload
 def extractOne(
     query: _S1,
@@ -29,6 +57,7 @@ def extractOne(
     processor: Callable[..., _StringType] | None = None,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[_S2, _ResultType, int]: ...
 @overload
@@ -40,9 +69,22 @@ def extractOne(
     processor: Callable[..., _StringType] | None = None,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[_S2, _ResultType, Any]: ...
 @overload
+def extractOne(
+    query: _S1,
+    choices: Corpus,
+    *,
+    scorer: Callable[..., _ResultType] = WRatio,
+    processor: Callable[..., _StringType] | None = None,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[Any, _ResultType, Any]: ...
+@overload
 def extract(
     query: _S1,
     choices: Collection[_S2],
@@ -52,6 +94,7 @@ def extract(
     limit: int | None = 5,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[_S2, _ResultType, int]]: ...
 @overload
@@ -64,9 +107,23 @@ def extract(
     limit: int | None = 5,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[_S2, _ResultType, Any]]: ...
 @overload
+def extract(
+    query: _S1,
+    choices: Corpus,
+    *,
+    scorer: Callable[..., _ResultType] = WRatio,
+    processor: Callable[..., _StringType] | None = None,
+    limit: int | None = 5,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> list[tuple[Any, _ResultType, Any]]: ...
+@overload
 def extract_iter(
     query: _S1,
     choices: Iterable[_S2],
@@ -93,8 +150,8 @@ try:
     import numpy as np
 
     def cdist(
-        queries: Iterable[_S1],
-        choices: Iterable[_S2],
+        queries: Iterable[_S1] | Corpus,
+        choices: Iterable[_S2] | Corpus,
         *,
         scorer: Callable[..., _ResultType] = ratio,
         processor: Callable[..., _StringType] | None = None,
@@ -103,7 +160,33 @@ try:
         dtype: np.dtype | None = None,
         workers: int = 1,
         scorer_kwargs: dict[str, Any] | None = None,
+        out: np.ndarray | None = None,
     ) -> np.ndarray: ...
+    def cdist_sparse(
+        queries: Iterable[_S1] | Corpus,
+        choices: Iterable[_S2] | Corpus,
+        *,
+        scorer: Callable[..., _ResultType] = ratio,
+        processor: Callable[..., _StringType] | None = None,
+        score_cutoff: _ResultType | None = None,
+        score_hint: _ResultType | None = None,
+        dtype: np.dtype | None = None,
+        workers: int = 1,
+        scorer_kwargs: dict[str, Any] | None = None,
+    ) -> tuple[np.ndarray, np.ndarray, np.ndarray]: ...
+    def cdist_topk(
+        queries: Iterable[_S1] | Corpus,
+        choices: Iterable[_S2] | Corpus,
+        *,
+        limit: int = 5,
+        scorer: Callable[..., _ResultType] = ratio,
+        processor: Callable[..., _StringType] | None = None,
+        score_cutoff: _ResultType | None = None,
+        score_hint: _ResultType | None = None,
+        dtype: np.dtype | None = None,
+        workers: int = 1,
+        scorer_kwargs: dict[str, Any] | None = None,
+    ) -> tuple[np.ndarray, np.ndarray]: ...
 
 except ImportError:
     pass
@@ -1,12 +1,24 @@
 #pragma once
+#include "bk_tree.hpp"
 #include "cpp_common.hpp"
+#include "qgram_index.hpp"
 #include "rapidfuzz.h"
-#include "taskflow/algorithm/for_each.hpp"
 #include "taskflow/taskflow.hpp"
+#include "utils.hpp"
+#include <algorithm>
 #include <atomic>
+#include <bitset>
 #include <chrono>
 #include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <unordered_map>
+#ifndef _WIN32
+#    include <pthread.h>
+#endif
+
 using namespace std::chrono_literals;
 
 template <typename T>
@@ -108,7 +120,7 @@ private:
 struct RF_ScorerWrapper {
     RF_ScorerFunc scorer_func;
 
-    RF_ScorerWrapper() : scorer_func({nullptr, {nullptr}, nullptr})
+    RF_ScorerWrapper() : scorer_func({nullptr, {nullptr}, nullptr, {nullptr}})
     {}
     explicit RF_ScorerWrapper(RF_ScorerFunc scorer_func_) : scorer_func(scorer_func_)
     {}
@@ -118,7 +130,7 @@ struct RF_ScorerWrapper {
 
     RF_ScorerWrapper(RF_ScorerWrapper&& other) : scorer_func(other.scorer_func)
     {
-        other.scorer_func = {nullptr, {nullptr}, nullptr};
+        other.scorer_func = {nullptr, {nullptr}, nullptr, {nullptr}};
     }
 
     RF_ScorerWrapper& operator=(RF_ScorerWrapper&& other)
@@ -129,7 +141,7 @@ struct RF_ScorerWrapper {
             }
 
             scorer_func = other.scorer_func;
-            other.scorer_func = {nullptr, {nullptr}, nullptr};
+            other.scorer_func = {nullptr, {nullptr}, nullptr, {nullptr}};
         }
         return *this;
     };
@@ -150,8 +162,55 @@ struct RF_ScorerWrapper {
     {
         PyErr2RuntimeExn(scorer_func.call.i64(&scorer_func, str, 1, score_cutoff, score_hint, result));
     }
+
+    /**
+     * @brief scores `str_count` strings, each one with its own score_cutoff. The results of `str[i]`
+     * are stored at `result + i * result_count`. Scorers without RF_ScorerFunc::call_batch are
+     * called once per string.
+     */
+    void call_batch(const RF_String* str, int64_t str_count, const double* score_cutoffs, double score_hint,
+                    double* result, size_t result_count = 1) const
+    {
+        if (scorer_func.call_batch.f64) {
+            PyErr2RuntimeExn(
+                scorer_func.call_batch.f64(&scorer_func, str, str_count, score_cutoffs, score_hint, result));
+            return;
+        }
+
+        for (int64_t i = 0; i < str_count; ++i)
+            call(&str[i], score_cutoffs[i], score_hint, result + static_cast<size_t>(i) * result_count);
+    }
+
+    void call_batch(const RF_String* str, int64_t str_count, const int64_t* score_cutoffs, int64_t score_hint,
+                    int64_t* result, size_t result_count = 1) const
+    {
+        if (scorer_func.call_batch.i64) {
+            PyErr2RuntimeExn(
+                scorer_func.call_batch.i64(&scorer_func, str, str_count, score_cutoffs, score_hint, result));
+            return;
+        }
+
+        for (int64_t i = 0; i < str_count; ++i)
+            call(&str[i], score_cutoffs[i], score_hint, result + static_cast<size_t>(i) * result_count);
+    }
 };
 
+/* number of strings passed into RF_ScorerWrapper::call_batch at once */
+static constexpr int64_t score_batch_size = 32;
+
+/**
+ * @brief constructs the RF_ScorerFunc of `scorer` for `str_count` strings
+ */
+static inline RF_ScorerWrapper init_scorer_func(const RF_Scorer* scorer, const RF_Kwargs* kwargs,
+                                                int64_t str_count, const RF_String* strings)
+{
+    RF_ScorerFunc scorer_func;
+    PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, str_count, strings));
+    /* scorers prior to version 3 do not set call_batch */
+    if (scorer->version < 3) scorer_func.call_batch.f64 = nullptr;
+    return RF_ScorerWrapper(scorer_func);
+}
+
 template <typename T>
 bool is_lowest_score_worst(const RF_ScorerFlags* scorer_flags)
 {
@@ -175,237 +234,130 @@ T get_optimal_score(const RF_ScorerFlags* scorer_flags)
 }
 
 template <typename T>
-std::vector<DictMatchElem<T>> extract_dict_impl(const RF_Kwargs* kwargs, const RF_ScorerFlags* scorer_flags,
-                                                RF_Scorer* scorer, const RF_StringWrapper& query,
-                                                const std::vector<DictStringElem>& choices, T score_cutoff,
-                                                T score_hint)
+T get_worst_score(const RF_ScorerFlags* scorer_flags)
 {
-    std::vector<DictMatchElem<T>> results;
-    results.reserve(choices.size());
-
-    RF_ScorerFunc scorer_func;
-    PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, 1, &query.string));
-    RF_ScorerWrapper ScorerFunc(scorer_func);
-
-    bool lowest_score_worst = is_lowest_score_worst<T>(scorer_flags);
-
-    for (size_t i = 0; i < choices.size(); ++i) {
-        if (i % 1000 == 0)
-            if (PyErr_CheckSignals() != 0) throw std::runtime_error("");
-
-        T score;
-        ScorerFunc.call(&choices[i].proc_val.string, score_cutoff, score_hint, &score);
-
-        if (lowest_score_worst) {
-            if (score >= score_cutoff) {
-                results.emplace_back(score, choices[i].index, choices[i].val, choices[i].key);
-            }
-        }
-        else {
-            if (score <= score_cutoff) {
-                results.emplace_back(score, choices[i].index, choices[i].val, choices[i].key);
-            }
-        }
+    if (std::is_same<T, double>::value) {
+        return (T)scorer_flags->worst_score.f64;
     }
-
-    return results;
-}
-
-template <typename T>
-std::vector<ListMatchElem<T>> extract_list_impl(const RF_Kwargs* kwargs, const RF_ScorerFlags* scorer_flags,
-                                                RF_Scorer* scorer, const RF_StringWrapper& query,
-                                                const std::vector<ListStringElem>& choices, T score_cutoff,
-                                                T score_hint)
-{
-    std::vector<ListMatchElem<T>> results;
-    results.reserve(choices.size());
-
-    RF_ScorerFunc scorer_func;
-    PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, 1, &query.string));
-    RF_ScorerWrapper ScorerFunc(scorer_func);
-
-    bool lowest_score_worst = is_lowest_score_worst<T>(scorer_flags);
-
-    for (size_t i = 0; i < choices.size(); ++i) {
-        if (i % 1000 == 0)
-            if (PyErr_CheckSignals() != 0) throw std::runtime_error("");
-
-        T score;
-        ScorerFunc.call(&choices[i].proc_val.string, score_cutoff, score_hint, &score);
-
-        if (lowest_score_worst) {
-            if (score >= score_cutoff) {
-                results.emplace_back(score, choices[i].index, choices[i].val);
-            }
-        }
-        else {
-            if (score <= score_cutoff) {
-                results.emplace_back(score, choices[i].index, choices[i].val);
-            }
-        }
+    else {
+        return (T)scorer_flags->worst_score.i64;
     }
-
-    return results;
-}
-
-int64_t any_round(double score)
-{
-    return std::llround(score);
 }
 
-int64_t any_round(int64_t score)
+bool KeyboardInterruptOccured(PyThreadState*& save)
 {
-    return score;
+    PyEval_RestoreThread(save);
+    bool res = PyErr_CheckSignals() != 0;
+    save = PyEval_SaveThread();
+    return res;
 }
 
-enum class MatrixType {
-    UNDEFINED,
-    FLOAT32,
-    FLOAT64,
-    INT8,
-    INT16,
-    INT32,
-    INT64,
-    UINT8,
-    UINT16,
-    UINT32,
-    UINT64,
-};
-
-struct Matrix {
-    MatrixType m_dtype;
-    size_t m_rows;
-    size_t m_cols;
-    void* m_matrix;
-
-    Matrix() : m_dtype(MatrixType::FLOAT32), m_rows(0), m_cols(0), m_matrix(nullptr)
-    {}
-
-    Matrix(MatrixType dtype, size_t rows, size_t cols) : m_dtype(dtype), m_rows(rows), m_cols(cols)
+/**
+ * @brief process wide tf::Executor shared by all calls to run_parallel, so the worker threads
+ * are only spawned once. It is created on first use and only recreated when more workers are
+ * requested than it has, so it is sized to the largest amount of workers requested so far.
+ * run_parallel limits each call to its own amount of workers. Runs still using a replaced
+ * executor keep it alive until they are done.
+ */
+class ThreadPool {
+public:
+    static std::shared_ptr<tf::Executor> get(size_t workers)
     {
+        std::lock_guard<std::mutex> lock(mutex());
+        std::shared_ptr<tf::Executor>& executor = instance();
+        if (!executor || executor->num_workers() < workers)
+            executor = std::make_shared<tf::Executor>(workers);
 
-        m_matrix = malloc(get_dtype_size() * m_rows * m_cols);
-        if (m_matrix == nullptr) throw std::bad_alloc();
-    }
-
-    Matrix(const Matrix& other) : m_dtype(other.m_dtype), m_rows(other.m_rows), m_cols(other.m_cols)
-    {
-        m_matrix = malloc(get_dtype_size() * m_rows * m_cols);
-        if (m_matrix == nullptr) throw std::bad_alloc();
-
-        memcpy(m_matrix, other.m_matrix, get_dtype_size() * m_rows * m_cols);
-    }
-
-    Matrix(Matrix&& other) noexcept : m_dtype(MatrixType::FLOAT32), m_rows(0), m_cols(0), m_matrix(nullptr)
-    {
-        other.swap(*this);
+        return executor;
     }
 
-    Matrix& operator=(Matrix other)
+    /* joins the worker threads. This is called at interpreter shutdown, since joining
+     * threads while the module is unloaded can deadlock */
+    static void shutdown()
     {
-        other.swap(*this);
-        return *this;
+        std::shared_ptr<tf::Executor> executor;
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            executor = std::move(instance());
+        }
     }
 
-    void swap(Matrix& rhs) noexcept
+private:
+    static std::mutex& mutex()
     {
-        using std::swap;
-        swap(m_rows, rhs.m_rows);
-        swap(m_cols, rhs.m_cols);
-        swap(m_dtype, rhs.m_dtype);
-        swap(m_matrix, rhs.m_matrix);
+        static std::mutex m;
+        return m;
     }
 
-    ~Matrix()
+    static std::shared_ptr<tf::Executor>& instance()
     {
-        free(m_matrix);
+        static std::shared_ptr<tf::Executor> executor;
+#ifndef _WIN32
+        static int registered = pthread_atfork(fork_prepare, fork_parent, fork_child);
+        (void)registered;
+#endif
+        return executor;
     }
 
-    int get_dtype_size()
+#ifndef _WIN32
+    static void fork_prepare()
     {
-        switch (m_dtype) {
-        case MatrixType::FLOAT32: return 4;
-        case MatrixType::FLOAT64: return 8;
-        case MatrixType::INT8: return 1;
-        case MatrixType::INT16: return 2;
-        case MatrixType::INT32: return 4;
-        case MatrixType::INT64: return 8;
-        case MatrixType::UINT8: return 1;
-        case MatrixType::UINT16: return 2;
-        case MatrixType::UINT32: return 4;
-        case MatrixType::UINT64: return 8;
-        default: throw std::invalid_argument("invalid dtype");
-        }
+        mutex().lock();
     }
 
-    const char* get_format()
+    static void fork_parent()
     {
-        switch (m_dtype) {
-        case MatrixType::FLOAT32: return "f";
-        case MatrixType::FLOAT64: return "d";
-        case MatrixType::INT8: return "b";
-        case MatrixType::INT16: return "h";
-        case MatrixType::INT32: return "i";
-        case MatrixType::INT64: return "q";
-        case MatrixType::UINT8: return "B";
-        case MatrixType::UINT16: return "H";
-        case MatrixType::UINT32: return "I";
-        case MatrixType::UINT64: return "Q";
-        default: throw std::invalid_argument("invalid dtype");
-        }
+        mutex().unlock();
     }
 
-    template <typename T>
-    void set(size_t row, size_t col, T score)
+    /* the worker threads do not exist in the child, so destructing the executor would wait
+     * for them forever. Instead it is leaked and a new one is created on the next use */
+    static void fork_child()
     {
-        void* data = (char*)m_matrix + get_dtype_size() * (row * m_cols + col);
-        switch (m_dtype) {
-        case MatrixType::FLOAT32: *((float*)data) = (float)score; break;
-        case MatrixType::FLOAT64: *((double*)data) = (double)score; break;
-        case MatrixType::INT8: *((int8_t*)data) = (int8_t)any_round(score); break;
-        case MatrixType::INT16: *((int16_t*)data) = (int16_t)any_round(score); break;
-        case MatrixType::INT32: *((int32_t*)data) = (int32_t)any_round(score); break;
-        case MatrixType::INT64: *((int64_t*)data) = any_round(score); break;
-        case MatrixType::UINT8: *((uint8_t*)data) = (uint8_t)any_round(score); break;
-        case MatrixType::UINT16: *((uint16_t*)data) = (uint16_t)any_round(score); break;
-        case MatrixType::UINT32: *((uint32_t*)data) = (uint32_t)any_round(score); break;
-        case MatrixType::UINT64: *((uint64_t*)data) = (uint64_t)any_round(score); break;
-        default: assert(false); break;
-        }
+        new std::shared_ptr<tf::Executor>(std::move(instance()));
+        mutex().unlock();
     }
+#endif
 };
 
-bool KeyboardInterruptOccured(PyThreadState*& save)
-{
-    PyEval_RestoreThread(save);
-    bool res = PyErr_CheckSignals() != 0;
-    save = PyEval_SaveThread();
-    return res;
-}
-
+/**
+ * @brief splits the rows [0, rows) into chunks of `step_size` rows, which are processed by `workers`
+ * tasks without holding the GIL. `func(next_chunk)` is called once for each task, so state like
+ * an initialized scorer can be reused for all chunks of the task. It processes the chunks
+ * [row, row_end) as long as `next_chunk(row, row_end)` returns true
+ */
 template <typename Func>
-void run_parallel(int workers, int64_t rows, int64_t step_size, Func&& func)
+void run_parallel_tasks(int workers, int64_t rows, int64_t step_size, Func&& func)
 {
     PyThreadState* save = PyEval_SaveThread();
 
     /* for these cases spawning threads causes to much overhead to be worth it */
     if (workers == 0 || workers == 1) {
-        for (int64_t row = 0; row < rows; row += step_size) {
+        int64_t next_row = 0;
+        bool interrupted = false;
+        auto next_chunk = [&](int64_t& row, int64_t& row_end) {
+            if (next_row >= rows) return false;
             if (KeyboardInterruptOccured(save)) {
-                PyEval_RestoreThread(save);
-                throw std::runtime_error("");
+                interrupted = true;
+                return false;
             }
 
-            try {
-                func(row, std::min(row + step_size, rows));
-            }
-            catch (...) {
-                PyEval_RestoreThread(save);
-                throw;
-            }
+            row = next_row;
+            row_end = next_row = std::min(row + step_size, rows);
+            return true;
+        };
+
+        try {
+            if (rows > 0) func(next_chunk);
+        }
+        catch (...) {
+            PyEval_RestoreThread(save);
+            throw;
         }
 
         PyEval_RestoreThread(save);
+        /* exception already set */
+        if (interrupted) throw std::runtime_error("");
         return;
     }
 
@@ -415,27 +367,39 @@ void run_parallel(int workers, int64_t rows, int64_t step_size, Func&& func)
 
     std::exception_ptr exception = nullptr;
     std::atomic<int> exceptions_occurred{0};
-    tf::Executor executor(workers);
+    std::shared_ptr<tf::Executor> executor = ThreadPool::get(static_cast<size_t>(workers));
     tf::Taskflow taskflow;
 
-    taskflow.for_each_index((int64_t)0, rows, step_size, [&](int64_t row) {
+    /* the executor can have more threads than requested, so only `workers` tasks are created,
+     * which take the chunks from a shared counter until all of them are processed */
+    std::atomic<int64_t> next_row{0};
+    auto next_chunk = [&](int64_t& row, int64_t& row_end) {
         /* skip work after an exception occurred */
-        if (exceptions_occurred.load() > 0) {
-            return;
-        }
-        try {
-            int64_t row_end = std::min(row + step_size, rows);
-            func(row, row_end);
-        }
-        catch (...) {
-            /* only store first exception */
-            if (exceptions_occurred.fetch_add(1) == 0) {
-                exception = std::current_exception();
+        if (exceptions_occurred.load() > 0) return false;
+
+        row = next_row.fetch_add(step_size);
+        if (row >= rows) return false;
+
+        row_end = std::min(row + step_size, rows);
+        return true;
+    };
+
+    int64_t tasks = std::min<int64_t>(workers, (rows + step_size - 1) / step_size);
+    for (int64_t task = 0; task < tasks; ++task) {
+        taskflow.emplace([&]() {
+            try {
+                func(next_chunk);
             }
-        }
-    });
+            catch (...) {
+                /* only store first exception */
+                if (exceptions_occurred.fetch_add(1) == 0) {
+                    exception = std::current_exception();
+                }
+            }
+        });
+    }
 
-    auto future = executor.run(taskflow);
+    auto future = executor->run(taskflow);
     while (future.wait_for(1s) != std::future_status::ready) {
         if (KeyboardInterruptOccured(save)) {
             exceptions_occurred.fetch_add(1);
@@ -450,171 +414,2152 @@ void run_parallel(int workers, int64_t rows, int64_t step_size, Func&& func)
     if (exception) std::rethrow_exception(exception);
 }
 
-template <typename T>
-static Matrix cdist_single_list_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
-                                     RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
-                                     MatrixType dtype, int workers, T score_cutoff, T score_hint,
-                                     T worst_score)
+template <typename Func>
+void run_parallel(int workers, int64_t rows, int64_t step_size, Func&& func)
 {
-    (void)scorer_flags;
-    int64_t rows = queries.size();
-    int64_t cols = queries.size();
-    Matrix matrix(dtype, static_cast<size_t>(rows), static_cast<size_t>(cols));
+    run_parallel_tasks(workers, rows, step_size, [&](auto&& next_chunk) {
+        int64_t row;
+        int64_t row_end;
+        while (next_chunk(row, row_end))
+            func(row, row_end);
+    });
+}
 
-    run_parallel(workers, rows, 1, [&](int64_t row, int64_t row_end) {
-        for (; row < row_end; ++row) {
-            RF_ScorerFunc scorer_func;
-            PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, 1, &queries[row].string));
-            RF_ScorerWrapper ScorerFunc(scorer_func);
+/**
+ * @brief run_parallel for units with a varying cost. The units are grouped into chunks of a
+ * similar estimated cost, with several chunks per worker, so workers finishing early pick up
+ * the remaining work. Units should be ordered by descending cost, so units which are more
+ * expensive than a whole chunk are started first.
+ */
+template <typename Func>
+void run_parallel_balanced(int workers, const std::vector<int64_t>& costs, Func&& func)
+{
+    if (workers < 0) {
+        workers = std::thread::hardware_concurrency();
+    }
 
-            T score;
-            if (queries[row].is_none())
-                score = worst_score;
-            else
-                ScorerFunc.call(&queries[row].string, score_cutoff, score_hint, &score);
+    const int64_t chunks_per_worker = 16;
+    int64_t total_cost = std::accumulate(costs.begin(), costs.end(), int64_t(0));
+    int64_t chunk_target = std::max<int64_t>(total_cost / (std::max(workers, 1) * chunks_per_worker), 1);
+
+    std::vector<int64_t> chunk_bounds = {0};
+    int64_t chunk_cost = 0;
+    for (size_t i = 0; i < costs.size(); ++i) {
+        chunk_cost += costs[i];
+        if (chunk_cost >= chunk_target) {
+            chunk_bounds.push_back(static_cast<int64_t>(i + 1));
+            chunk_cost = 0;
+        }
+    }
+    if (chunk_bounds.back() != static_cast<int64_t>(costs.size()))
+        chunk_bounds.push_back(static_cast<int64_t>(costs.size()));
+
+    run_parallel(workers, static_cast<int64_t>(chunk_bounds.size() - 1), 1,
+                 [&](int64_t chunk, int64_t chunk_end) {
+                     func(chunk_bounds[static_cast<size_t>(chunk)],
+                          chunk_bounds[static_cast<size_t>(chunk_end)]);
+                 });
+}
 
-            matrix.set(row, row, score);
+template <typename CharT>
+static inline void default_process_into(RF_String& sentence, void* buffer)
+{
+    CharT* str = static_cast<CharT*>(buffer);
+    const CharT* first = static_cast<const CharT*>(sentence.data);
+    std::copy(first, first + sentence.length, str);
 
-            for (int64_t col = row + 1; col < cols; ++col) {
-                if (queries[col].is_none())
-                    score = worst_score;
-                else
-                    ScorerFunc.call(&queries[col].string, score_cutoff, score_hint, &score);
+    sentence.data = str;
+    sentence.length = default_process(str, sentence.length);
+}
 
-                matrix.set(row, col, score);
-                matrix.set(col, row, score);
+/**
+ * @brief applies utils.default_process to `count` strings, which still point into the unprocessed
+ * Python strings. `string_at(i)` returns the i-th string and None is skipped. The processed strings
+ * are written into a single buffer of the arena, which is filled by `workers` threads without
+ * holding the GIL
+ */
+template <typename StringAt>
+static inline void default_process_batch(int64_t count, StringAt&& string_at, StringArena& arena,
+                                         int workers)
+{
+    /* strings are placed at the same 8 byte alignment the arena uses for separate allocations */
+    std::vector<size_t> offsets(static_cast<size_t>(count) + 1, 0);
+    for (int64_t i = 0; i < count; ++i) {
+        const RF_String& str = string_at(i);
+        size_t size = 0;
+        if (str.data != nullptr) {
+            size = static_cast<size_t>(str.length) << static_cast<size_t>(str.kind);
+            size = (std::max<size_t>(size, 1) + 7) & ~static_cast<size_t>(7);
+        }
+        offsets[static_cast<size_t>(i) + 1] = offsets[static_cast<size_t>(i)] + size;
+    }
+    char* buffer = static_cast<char*>(arena.allocate(offsets.back()));
+
+    run_parallel(workers, count, 4096, [&](int64_t start, int64_t end) {
+        for (int64_t i = start; i < end; ++i) {
+            RF_String& str = string_at(i);
+            if (str.data == nullptr) continue;
+
+            void* dest = buffer + offsets[static_cast<size_t>(i)];
+            switch (str.kind) {
+#define X_ENUM(KIND, TYPE)                                                                                   \
+    case KIND: default_process_into<TYPE>(str, dest); break;
+                LIST_OF_CASES()
+#undef X_ENUM
+            default: throw std::logic_error("Reached end of control flow in default_process_batch");
             }
         }
     });
-
-    return matrix;
 }
 
-template <typename T>
-static Matrix cdist_two_lists_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
-                                   RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
-                                   const std::vector<RF_StringWrapper>& choices, MatrixType dtype,
-                                   int workers, T score_cutoff, T score_hint, T worst_score)
+static inline void default_process_batch(std::vector<RF_StringWrapper>& strings, StringArena& arena,
+                                         int workers)
 {
-    int64_t rows = queries.size();
-    int64_t cols = choices.size();
-    Matrix matrix(dtype, static_cast<size_t>(rows), static_cast<size_t>(cols));
-    bool multiStringInit = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_INIT;
+    auto string_at = [&](int64_t i) -> RF_String& {
+        return strings[static_cast<size_t>(i)].string;
+    };
+    default_process_batch(static_cast<int64_t>(strings.size()), string_at, arena, workers);
+}
 
-    if (queries.empty() || choices.empty()) return matrix;
+static inline void default_process_batch(std::vector<ListStringElem>& strings, StringArena& arena,
+                                         int workers)
+{
+    auto string_at = [&](int64_t i) -> RF_String& {
+        return strings[static_cast<size_t>(i)].proc_val.string;
+    };
+    default_process_batch(static_cast<int64_t>(strings.size()), string_at, arena, workers);
+}
 
-    if (multiStringInit) {
-        std::vector<size_t> row_idx(rows);
-        std::iota(row_idx.begin(), row_idx.end(), 0);
-        auto none_begin = std::remove_if(row_idx.begin(), row_idx.end(), [&queries](size_t i) {
-            return queries[i].is_none();
-        });
+static inline void default_process_batch(std::vector<DictStringElem>& strings, StringArena& arena,
+                                         int workers)
+{
+    auto string_at = [&](int64_t i) -> RF_String& {
+        return strings[static_cast<size_t>(i)].proc_val.string;
+    };
+    default_process_batch(static_cast<int64_t>(strings.size()), string_at, arena, workers);
+}
 
-        for (auto it = none_begin; it != row_idx.end(); it++)
-            for (int64_t col = 0; col < cols; ++col)
-                matrix.set(*it, col, worst_score);
+template <typename T>
+struct IndexMatchElem {
+    IndexMatchElem()
+    {}
+    IndexMatchElem(T score, int64_t index) : score(score), index(index)
+    {}
 
-        row_idx.erase(none_begin, row_idx.end());
+    T score;
+    int64_t index;
+};
 
-        /* all elements are None */
-        if (row_idx.empty()) return matrix;
+template <typename T>
+static inline bool score_within_cutoff(T score, T score_cutoff, bool lowest_score_worst)
+{
+    return lowest_score_worst ? score >= score_cutoff : score <= score_cutoff;
+}
 
-        /* sort into blocks fitting simd vectors */
-        std::stable_sort(row_idx.begin(), row_idx.end(), [&queries](size_t i1, size_t i2) {
-            size_t len1 = queries[i1].size();
-            if (len1 <= 64)
-                len1 = len1 / 8;
-            else
-                len1 = (64 / 8) + len1 / 64;
+/**
+ * @brief bounded heap keeping track of the best `limit` matches. Once it is filled
+ * the worst match in the heap is used as score_cutoff, since any choice scoring
+ * worse can not be part of the results anymore. This allows the scorer to exit early.
+ */
+template <typename T>
+class ExtractTopK {
+public:
+    ExtractTopK(const RF_ScorerFlags* scorer_flags, int64_t limit, T score_cutoff)
+        : m_comp(scorer_flags),
+          m_limit(static_cast<size_t>(limit)),
+          m_score_cutoff(score_cutoff),
+          m_lowest_score_worst(is_lowest_score_worst<T>(scorer_flags))
+    {
+        m_heap.reserve(std::min<size_t>(m_limit, 1024));
+    }
+
+    T score_cutoff() const
+    {
+        return m_score_cutoff;
+    }
+
+    bool full() const
+    {
+        return m_heap.size() >= m_limit;
+    }
+
+    /* returns whether the match was inserted */
+    bool push(T score, int64_t index)
+    {
+        if (!score_within_cutoff(score, m_score_cutoff, m_lowest_score_worst)) return false;
+
+        IndexMatchElem<T> elem(score, index);
+        if (!full()) {
+            m_heap.push_back(elem);
+            std::push_heap(m_heap.begin(), m_heap.end(), m_comp);
+        }
+        else {
+            /* the heap front is the worst match */
+            if (!m_comp(elem, m_heap.front())) return false;
+
+            std::pop_heap(m_heap.begin(), m_heap.end(), m_comp);
+            m_heap.back() = elem;
+            std::push_heap(m_heap.begin(), m_heap.end(), m_comp);
+        }
+
+        if (full()) m_score_cutoff = m_heap.front().score;
+
+        return true;
+    }
+
+    void merge(const ExtractTopK& other)
+    {
+        for (const auto& elem : other.m_heap)
+            push(elem.score, elem.index);
+    }
+
+    /* sorted matches. The heap is empty afterwards */
+    std::vector<IndexMatchElem<T>> take_sorted()
+    {
+        std::sort_heap(m_heap.begin(), m_heap.end(), m_comp);
+        return std::move(m_heap);
+    }
+
+private:
+    ExtractComp m_comp;
+    size_t m_limit;
+    T m_score_cutoff;
+    bool m_lowest_score_worst;
+    std::vector<IndexMatchElem<T>> m_heap;
+};
+
+/**
+ * @brief choices grouped by their length for scorers flagged with RF_SCORER_FLAG_LENGTH_BOUND,
+ * so all choices of a length can be skipped at once. Choices of the same length keep their order.
+ * None is left out.
+ */
+class LengthBuckets {
+public:
+    LengthBuckets() : m_built(false)
+    {}
+
+    template <typename ChoiceFunc>
+    void build(int64_t count, ChoiceFunc&& get_choice)
+    {
+        std::vector<std::pair<size_t, int64_t>> by_length;
+        by_length.reserve(static_cast<size_t>(count));
+        for (int64_t i = 0; i < count; ++i) {
+            const RF_StringWrapper& choice = get_choice(i);
+            if (!choice.is_none()) by_length.emplace_back(choice.size(), i);
+        }
+        std::sort(by_length.begin(), by_length.end());
+
+        m_lengths.clear();
+        m_offsets.clear();
+        m_choices.clear();
+        m_choices.reserve(by_length.size());
+        for (const auto& elem : by_length) {
+            if (m_lengths.empty() || m_lengths.back() != elem.first) {
+                m_lengths.push_back(elem.first);
+                m_offsets.push_back(static_cast<int64_t>(m_choices.size()));
+            }
+            m_choices.push_back(elem.second);
+        }
+        m_offsets.push_back(static_cast<int64_t>(m_choices.size()));
+        m_built = true;
+    }
+
+    void build(const std::vector<RF_StringWrapper>& strings)
+    {
+        build(static_cast<int64_t>(strings.size()), [&](int64_t i) -> const RF_StringWrapper& {
+            return strings[static_cast<size_t>(i)];
+        });
+    }
+
+    bool built() const noexcept
+    {
+        return m_built;
+    }
+
+    size_t bucket_count() const noexcept
+    {
+        return m_lengths.size();
+    }
+
+    size_t length(size_t bucket) const
+    {
+        return m_lengths[bucket];
+    }
+
+    int64_t bucket_size(size_t bucket) const
+    {
+        return m_offsets[bucket + 1] - m_offsets[bucket];
+    }
+
+    /* choice `pos` of a bucket. They are sorted by their index */
+    int64_t choice(size_t bucket, int64_t pos) const
+    {
+        return m_choices[static_cast<size_t>(m_offsets[bucket] + pos)];
+    }
+
+    size_t max_length() const noexcept
+    {
+        return m_lengths.empty() ? 0 : m_lengths.back();
+    }
+
+    /**
+     * @brief buckets sorted by the difference between their length and `query_len`, so good
+     * matches are usually found early on. At the same difference shorter choices come first.
+     */
+    std::vector<size_t> visit_order(size_t query_len) const
+    {
+        std::vector<size_t> order;
+        order.reserve(m_lengths.size());
+        size_t longer = static_cast<size_t>(std::lower_bound(m_lengths.begin(), m_lengths.end(), query_len) -
+                                            m_lengths.begin());
+        size_t shorter = longer;
+        while (shorter > 0 || longer < m_lengths.size()) {
+            if (longer == m_lengths.size() ||
+                (shorter > 0 && query_len - m_lengths[shorter - 1] <= m_lengths[longer] - query_len))
+                order.push_back(--shorter);
+            else
+                order.push_back(longer++);
+        }
+        return order;
+    }
+
+private:
+    bool m_built;
+    /* distinct lengths in ascending order */
+    std::vector<size_t> m_lengths;
+    /* choices of m_lengths[i] are stored in m_choices[m_offsets[i], m_offsets[i + 1]) */
+    std::vector<int64_t> m_offsets;
+    std::vector<int64_t> m_choices;
+};
+
+/**
+ * @brief the query padded with zeros. Its prefixes are the best possible choices of each length
+ * for scorers flagged with RF_SCORER_FLAG_LENGTH_BOUND
+ */
+class LengthBoundString {
+public:
+    LengthBoundString(const RF_String& query, size_t max_len)
+        : m_query(query), m_data((size_t(1) << query.kind) * std::max<size_t>(max_len, 1), 0)
+    {
+        size_t copy_len = std::min(static_cast<size_t>(query.length), max_len);
+        if (copy_len) memcpy(m_data.data(), query.data, copy_len * (size_t(1) << query.kind));
+    }
+
+    RF_String get(size_t len) const
+    {
+        return {nullptr, m_query.kind, const_cast<char*>(m_data.data()), static_cast<int64_t>(len), nullptr};
+    }
+
+private:
+    RF_String m_query;
+    std::vector<char> m_data;
+};
+
+/**
+ * @brief the query with its first characters replaced by a character it does not contain. For
+ * scorers flagged with RF_SCORER_FLAG_LCS_BOUND these are the best possible choices of each
+ * length, which share a longest common subsequence of a given length with the query
+ */
+class LcsBoundString {
+public:
+    explicit LcsBoundString(const RF_String& query)
+        : m_query(visit(query, [](auto s) {
+              return std::vector<uint64_t>(s.begin(), s.end());
+          })),
+          m_fill(0)
+    {
+        std::vector<uint64_t> chars = m_query;
+        std::sort(chars.begin(), chars.end());
+        chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+        for (uint64_t ch : chars) {
+            if (ch != m_fill) break;
+            ++m_fill;
+        }
+    }
+
+    /* string of length `len` with the first `replaced` characters of the query replaced */
+    RF_String get(size_t len, size_t replaced)
+    {
+        m_data.assign(std::max<size_t>(len, 1), m_fill);
+        size_t copy_len = std::min(len, m_query.size());
+        if (replaced < copy_len)
+            std::copy(m_query.begin() + static_cast<ptrdiff_t>(replaced),
+                      m_query.begin() + static_cast<ptrdiff_t>(copy_len),
+                      m_data.begin() + static_cast<ptrdiff_t>(replaced));
+
+        return {nullptr, RF_UINT64, m_data.data(), static_cast<int64_t>(len), nullptr};
+    }
+
+private:
+    std::vector<uint64_t> m_query;
+    /* smallest character not contained in the query */
+    uint64_t m_fill;
+    std::vector<uint64_t> m_data;
+};
+
+/**
+ * @brief minimum number of q-grams the choices of each length in `index` have to share with the
+ * query to reach the score_cutoff. For scorers flagged with RF_SCORER_FLAG_LCS_BOUND the longest
+ * common subsequence with the query has to be at least L characters long, where L is found by
+ * scoring LcsBoundString. Each of the m - L characters of the query outside of it removes at most
+ * q of the m - q + 1 q-grams of the query and each of the n - L characters of a choice of length n
+ * outside of it at most q - 1, so they share at least m - q + 1 - q * (m - L) - (q - 1) * (n - L)
+ * q-grams. The same holds with the query and the choice swapped.
+ */
+template <typename T>
+static std::vector<int64_t> qgram_min_shared(const QGramIndex& index, const RF_ScorerWrapper& ScorerFunc,
+                                             const RF_String& query, T score_cutoff, T score_hint,
+                                             bool lowest_score_worst)
+{
+    LcsBoundString bound_string(query);
+    int64_t q = static_cast<int64_t>(index.qgram_size());
+    int64_t m = query.length;
+
+    std::vector<int64_t> min_shared;
+    min_shared.reserve(index.lengths().size());
+    for (size_t len : index.lengths()) {
+        auto reaches_cutoff = [&](size_t replaced) {
+            T score;
+            RF_String str = bound_string.get(len, replaced);
+            ScorerFunc.call(&str, score_cutoff, score_hint, &score);
+            return score_within_cutoff(score, score_cutoff, lowest_score_worst);
+        };
+
+        if (!reaches_cutoff(0)) {
+            min_shared.push_back(QGramIndex::no_candidates);
+            continue;
+        }
+
+        /* the most characters, which can be replaced without missing the score_cutoff */
+        size_t low = 0;
+        size_t high = std::min(len, static_cast<size_t>(m));
+        while (low < high) {
+            size_t mid = low + (high - low + 1) / 2;
+            if (reaches_cutoff(mid))
+                low = mid;
+            else
+                high = mid - 1;
+        }
+
+        int64_t n = static_cast<int64_t>(len);
+        int64_t lcs = std::min(m, n) - static_cast<int64_t>(low);
+        min_shared.push_back(std::max(m - q + 1 - q * (m - lcs) - (q - 1) * (n - lcs),
+                                      n - q + 1 - q * (n - lcs) - (q - 1) * (m - lcs)));
+    }
+    return min_shared;
+}
+
+/**
+ * @brief score stored for strings rejected without calling the scorer. The scorers return it for
+ * strings, which do not reach the score_cutoff: score_cutoff + 1 for distances and the worst
+ * score otherwise
+ */
+template <typename T>
+static inline T rejected_score(T score_cutoff, T worst_score, bool lowest_score_worst)
+{
+    if constexpr (std::is_integral<T>::value)
+        if (!lowest_score_worst && score_cutoff < worst_score) return score_cutoff + 1;
+
+    return worst_score;
+}
+
+/**
+ * @brief 64 bit signature of the characters contained in a string. Each character sets the bit
+ * ch % 64, so characters sharing a bit can not be told apart, which only weakens the bounds below
+ */
+static inline uint64_t char_signature(const RF_String& str)
+{
+    return visit(str, [](auto s) {
+        uint64_t signature = 0;
+        for (auto ch : s)
+            signature |= uint64_t(1) << (static_cast<uint64_t>(ch) % 64);
+        return signature;
+    });
+}
+
+/**
+ * @brief character signatures of a list of strings, which are stored next to them, so strings
+ * can be rejected without accessing them. The strings are grouped by their length, so bounds
+ * computed for a length can be reused for all strings of this length.
+ */
+class CharSignatures {
+public:
+    CharSignatures() : m_built(false)
+    {}
+
+    template <typename StringFunc>
+    void build(size_t count, StringFunc&& get_string)
+    {
+        m_signatures.assign(count, 0);
+        m_length_ids.assign(count, 0);
+        m_lengths.clear();
+
+        std::unordered_map<size_t, uint32_t> length_ids;
+        for (size_t i = 0; i < count; ++i) {
+            const RF_StringWrapper& str = get_string(i);
+            if (str.is_none()) continue;
+
+            auto length_id = length_ids.emplace(str.size(), static_cast<uint32_t>(m_lengths.size()));
+            if (length_id.second) m_lengths.push_back(str.size());
+            m_length_ids[i] = length_id.first->second;
+            m_signatures[i] = char_signature(str.string);
+        }
+        m_built = true;
+    }
+
+    void build(const std::vector<RF_StringWrapper>& strings)
+    {
+        build(strings.size(), [&](size_t i) -> const RF_StringWrapper& {
+            return strings[i];
+        });
+    }
+
+    bool built() const noexcept
+    {
+        return m_built;
+    }
+
+    uint64_t signature(size_t index) const
+    {
+        return m_signatures[index];
+    }
+
+    size_t length(size_t index) const
+    {
+        return m_lengths[m_length_ids[index]];
+    }
+
+    uint32_t length_id(size_t index) const
+    {
+        return m_length_ids[index];
+    }
+
+    /* number of distinct lengths */
+    size_t length_count() const noexcept
+    {
+        return m_lengths.size();
+    }
+
+private:
+    bool m_built;
+    std::vector<uint64_t> m_signatures;
+    std::vector<uint32_t> m_length_ids;
+    std::vector<size_t> m_lengths;
+};
+
+/**
+ * @brief rejects strings based on their character signature for scorers flagged with
+ * RF_SCORER_FLAG_LCS_BOUND. For a query of length m and a string of length n, each of the a bits
+ * only set for the query is a character of the query outside of their longest common subsequence
+ * and each of the b bits only set for the string a character of the string outside of it. So at
+ * least max(a - max(m - n, 0), b - max(n - m, 0)) characters of LcsBoundString are replaced.
+ * The results of scoring LcsBoundString are cached for each length, so most strings are rejected
+ * using two popcounts without calling the scorer.
+ */
+template <typename T>
+class CharSignatureFilter {
+public:
+    CharSignatureFilter(const CharSignatures& signatures, const RF_String& query,
+                        const RF_ScorerWrapper& ScorerFunc, T score_cutoff, T score_hint,
+                        bool lowest_score_worst)
+        : m_signatures(signatures),
+          m_ScorerFunc(ScorerFunc),
+          m_bound_string(query),
+          m_query_signature(char_signature(query)),
+          m_query_len(static_cast<size_t>(query.length)),
+          m_score_cutoff(score_cutoff),
+          m_score_hint(score_hint),
+          m_lowest_score_worst(lowest_score_worst),
+          m_generation(1),
+          m_bounds(signatures.length_count())
+    {}
+
+    /* the cached bounds are only valid for the score_cutoff they were computed with */
+    void set_score_cutoff(T score_cutoff)
+    {
+        if (score_cutoff == m_score_cutoff) return;
+
+        m_score_cutoff = score_cutoff;
+        ++m_generation;
+    }
+
+    /* whether string `index` can not reach the score_cutoff */
+    bool rejects(size_t index)
+    {
+        size_t len = m_signatures.length(index);
+        uint64_t signature = m_signatures.signature(index);
+        size_t query_only = std::bitset<64>(m_query_signature & ~signature).count();
+        size_t choice_only = std::bitset<64>(signature & ~m_query_signature).count();
+        size_t query_extra = (m_query_len > len) ? m_query_len - len : 0;
+        size_t choice_extra = (len > m_query_len) ? len - m_query_len : 0;
+        size_t replaced = std::max((query_only > query_extra) ? query_only - query_extra : 0,
+                                   (choice_only > choice_extra) ? choice_only - choice_extra : 0);
+        if (!replaced) return false;
+
+        LengthBound& bound = m_bounds[m_signatures.length_id(index)];
+        if (bound.generation != m_generation) bound = {m_generation, 0, std::numeric_limits<size_t>::max()};
+        if (replaced <= bound.max_reached) return false;
+        if (replaced >= bound.min_missed) return true;
+
+        T score;
+        RF_String str = m_bound_string.get(len, replaced);
+        m_ScorerFunc.call(&str, m_score_cutoff, m_score_hint, &score);
+        if (score_within_cutoff(score, m_score_cutoff, m_lowest_score_worst)) {
+            bound.max_reached = replaced;
+            return false;
+        }
+
+        bound.min_missed = replaced;
+        return true;
+    }
+
+private:
+    /* the score_cutoff is reached with up to max_reached and missed with min_missed or more
+     * replaced characters */
+    struct LengthBound {
+        uint64_t generation;
+        size_t max_reached;
+        size_t min_missed;
+    };
+
+    const CharSignatures& m_signatures;
+    const RF_ScorerWrapper& m_ScorerFunc;
+    LcsBoundString m_bound_string;
+    uint64_t m_query_signature;
+    size_t m_query_len;
+    T m_score_cutoff;
+    T m_score_hint;
+    bool m_lowest_score_worst;
+    uint64_t m_generation;
+    std::vector<LengthBound> m_bounds;
+};
+
+/**
+ * @brief compare the query with the choices [0, choice_count) and return the best `limit`
+ * matches sorted using ExtractComp. The index of the matches is the position passed
+ * into `get_choice`.
+ *
+ * The choices are scored in chunks. Each chunk keeps its best `limit` matches in an
+ * ExtractTopK, which is merged into the overall result. The chunks start with the
+ * score_cutoff of the overall result, so later chunks benefit from earlier ones.
+ * The chunks are scored using run_parallel, so the GIL is released even with workers = 0/1,
+ * in which case they are scored on the calling thread.
+ *
+ * For scorers flagged with RF_SCORER_FLAG_LCS_BOUND choices are rejected based on their character
+ * signature before scoring them, when the `signatures` of the choices are stored next to them.
+ * Computing them requires a pass over all choices, so they are only stored by a Corpus.
+ * The `length_buckets` of scorers flagged with RF_SCORER_FLAG_LENGTH_BOUND can be passed as well.
+ * Otherwise they are computed for each call.
+ */
+template <typename T, typename ChoiceFunc>
+std::vector<IndexMatchElem<T>> extract_index_impl(const RF_Kwargs* kwargs,
+                                                  const RF_ScorerFlags* scorer_flags, RF_Scorer* scorer,
+                                                  const RF_StringWrapper& query, int64_t choice_count,
+                                                  ChoiceFunc&& get_choice, int64_t limit, T score_cutoff,
+                                                  T score_hint, int workers,
+                                                  const CharSignatures* signatures = nullptr,
+                                                  const LengthBuckets* length_buckets = nullptr)
+{
+    if (limit <= 0 || choice_count <= 0) return {};
+
+    const int64_t chunk_size = 1024;
+    T optimal_score = get_optimal_score<T>(scorer_flags);
+    bool lowest_score_worst = is_lowest_score_worst<T>(scorer_flags);
+
+    /* the choices are visited bucket by bucket starting with the length of the query and lengths,
+     * which can not reach the score_cutoff, are skipped. Otherwise they are visited in order of
+     * their index */
+    bool length_bound = (scorer_flags->flags & RF_SCORER_FLAG_LENGTH_BOUND) != 0;
+    LengthBuckets choice_buckets;
+    if (!length_bound) {
+        length_buckets = nullptr;
+    }
+    else if (!length_buckets) {
+        run_parallel(1, 1, 1, [&](int64_t, int64_t) {
+            choice_buckets.build(choice_count, get_choice);
+        });
+        length_buckets = &choice_buckets;
+    }
+
+    size_t query_len = query.size();
+    std::vector<size_t> visit;
+    /* the buckets visit[k] are scored at the positions [visit_offsets[k], visit_offsets[k + 1]) */
+    std::vector<int64_t> visit_offsets(1, 0);
+    /* the bound of a length only gets worse moving away from the length of the query. So
+     * once a length is skipped, all lengths with at least this difference on the same side
+     * of the query are skipped as well. The differences start past the last bucket of each side */
+    std::atomic<size_t> shorter_stop{0};
+    std::atomic<size_t> longer_stop{0};
+    if (length_buckets) {
+        visit = length_buckets->visit_order(query_len);
+        for (size_t bucket : visit) {
+            visit_offsets.push_back(visit_offsets.back() + length_buckets->bucket_size(bucket));
+
+            size_t len = length_buckets->length(bucket);
+            if (len < query_len)
+                shorter_stop = std::max(shorter_stop.load(), query_len - len + 1);
+            else
+                longer_stop = std::max(longer_stop.load(), len - query_len + 1);
+        }
+    }
+    LengthBoundString bound_string(query.string, length_buckets ? length_buckets->max_length() : 0);
+    int64_t position_count = length_buckets ? visit_offsets.back() : choice_count;
+
+    /* without a score_cutoff no choice can be rejected until `limit` matches are found */
+    bool use_signatures = (scorer_flags->flags & RF_SCORER_FLAG_LCS_BOUND) && !query.is_none() &&
+                          (limit < choice_count || score_cutoff != get_worst_score<T>(scorer_flags));
+    if (!use_signatures) signatures = nullptr;
+
+    /* when only the best match is requested, no choice after a perfect match can improve the result */
+    std::atomic<int64_t> optimal_index{choice_count};
+    std::mutex results_mutex;
+    ExtractTopK<T> results(scorer_flags, limit, score_cutoff);
+
+    /* the scorer and the signature filter are initialized once for each task and reused for
+     * all of its chunks */
+    auto score_task = [&](auto&& next_chunk) {
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &query.string);
+        std::unique_ptr<CharSignatureFilter<T>> signature_filter;
+        if (signatures)
+            signature_filter.reset(new CharSignatureFilter<T>(*signatures, query.string, ScorerFunc,
+                                                              score_cutoff, score_hint, lowest_score_worst));
+
+        RF_String strings[score_batch_size];
+        int64_t indices[score_batch_size];
+        T score_cutoffs[score_batch_size];
+        T scores[score_batch_size];
+
+        int64_t i;
+        int64_t end;
+        while (next_chunk(i, end)) {
+            if (!length_buckets && i > optimal_index.load()) continue;
+
+            T chunk_score_cutoff;
+            {
+                std::lock_guard<std::mutex> guard(results_mutex);
+                chunk_score_cutoff = results.score_cutoff();
+            }
+
+            ExtractTopK<T> chunk_results(scorer_flags, limit, chunk_score_cutoff);
+            /* whether all choices of a bucket are skipped */
+            auto skip_bucket = [&](size_t bucket) {
+                size_t len = length_buckets->length(bucket);
+                std::atomic<size_t>& stop = (len < query_len) ? shorter_stop : longer_stop;
+                size_t diff = (len < query_len) ? query_len - len : len - query_len;
+                if (diff >= stop.load()) return true;
+
+                T bound;
+                RF_String bound_str = bound_string.get(len);
+                ScorerFunc.call(&bound_str, chunk_results.score_cutoff(), score_hint, &bound);
+                if (score_within_cutoff(bound, chunk_results.score_cutoff(), lowest_score_worst))
+                    return false;
+
+                size_t prev = stop.load();
+                while (diff < prev && !stop.compare_exchange_weak(prev, diff)) {}
+                return true;
+            };
+
+            /* bucket of the current position and the position its choices end at */
+            size_t visit_pos = 0;
+            int64_t bucket_end = i;
+            bool optimal_found = false;
+            while (i < end && !optimal_found) {
+                if (signature_filter) signature_filter->set_score_cutoff(chunk_results.score_cutoff());
+
+                int64_t batch_count = 0;
+                for (; i < end && batch_count < score_batch_size; ++i) {
+                    int64_t index = i;
+                    if (length_buckets) {
+                        if (i == bucket_end) {
+                            visit_pos = static_cast<size_t>(
+                                std::upper_bound(visit_offsets.begin(), visit_offsets.end(), i) -
+                                visit_offsets.begin() - 1);
+                            bucket_end = visit_offsets[visit_pos + 1];
+                            if (skip_bucket(visit[visit_pos])) {
+                                /* the remaining buckets are at least as far away from the query */
+                                size_t len = length_buckets->length(visit[visit_pos]);
+                                size_t diff = (len < query_len) ? query_len - len : len - query_len;
+                                if (diff >= std::max(shorter_stop.load(), longer_stop.load())) {
+                                    i = end;
+                                    break;
+                                }
+
+                                i = std::min(bucket_end, end) - 1;
+                                continue;
+                            }
+                        }
+
+                        index = length_buckets->choice(visit[visit_pos], i - visit_offsets[visit_pos]);
+                        /* the choices of a bucket are sorted by their index */
+                        if (index > optimal_index.load()) {
+                            i = std::min(bucket_end, end) - 1;
+                            continue;
+                        }
+                    }
+                    else if (index > optimal_index.load()) {
+                        continue;
+                    }
+
+                    const RF_StringWrapper& choice = get_choice(index);
+                    if (choice.is_none()) continue;
+
+                    if (signature_filter && signature_filter->rejects(static_cast<size_t>(index))) continue;
+
+                    strings[batch_count] = choice.string;
+                    indices[batch_count] = index;
+                    ++batch_count;
+                }
+
+                /* the cutoff is only updated between batches, so the heap filters the results again */
+                std::fill(score_cutoffs, score_cutoffs + batch_count, chunk_results.score_cutoff());
+                ScorerFunc.call_batch(strings, batch_count, score_cutoffs, score_hint, scores);
+
+                for (int64_t k = 0; k < batch_count; ++k) {
+                    if (!chunk_results.push(scores[k], indices[k])) continue;
+
+                    if (limit == 1 && scores[k] == optimal_score) {
+                        int64_t prev = optimal_index.load();
+                        while (indices[k] < prev && !optimal_index.compare_exchange_weak(prev, indices[k])) {}
+                        /* the remaining choices are only known to have a larger index when visiting
+                         * them in order of their index. Otherwise the bounds skip all lengths, which
+                         * can not reach the optimal score */
+                        if (!length_buckets) {
+                            optimal_found = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(results_mutex);
+            results.merge(chunk_results);
+        }
+    };
+
+    run_parallel_tasks(workers, position_count, chunk_size, score_task);
+    return results.take_sorted();
+}
+
+template <typename T>
+std::vector<DictMatchElem<T>> extract_dict_impl(const RF_Kwargs* kwargs, const RF_ScorerFlags* scorer_flags,
+                                                RF_Scorer* scorer, const RF_StringWrapper& query,
+                                                const std::vector<DictStringElem>& choices, T score_cutoff,
+                                                T score_hint, int64_t limit, int workers)
+{
+    auto matches = extract_index_impl<T>(
+        kwargs, scorer_flags, scorer, query, static_cast<int64_t>(choices.size()),
+        [&](int64_t i) -> const RF_StringWrapper& {
+            return choices[static_cast<size_t>(i)].proc_val;
+        },
+        limit, score_cutoff, score_hint, workers);
+
+    std::vector<DictMatchElem<T>> results;
+    results.reserve(matches.size());
+    for (const auto& match : matches) {
+        const auto& choice = choices[static_cast<size_t>(match.index)];
+        results.emplace_back(match.score, choice.index, choice.val, choice.key);
+    }
+
+    return results;
+}
+
+template <typename T>
+std::vector<ListMatchElem<T>> extract_list_impl(const RF_Kwargs* kwargs, const RF_ScorerFlags* scorer_flags,
+                                                RF_Scorer* scorer, const RF_StringWrapper& query,
+                                                const std::vector<ListStringElem>& choices, T score_cutoff,
+                                                T score_hint, int64_t limit, int workers)
+{
+    auto matches = extract_index_impl<T>(
+        kwargs, scorer_flags, scorer, query, static_cast<int64_t>(choices.size()),
+        [&](int64_t i) -> const RF_StringWrapper& {
+            return choices[static_cast<size_t>(i)].proc_val;
+        },
+        limit, score_cutoff, score_hint, workers);
+
+    std::vector<ListMatchElem<T>> results;
+    results.reserve(matches.size());
+    for (const auto& match : matches) {
+        const auto& choice = choices[static_cast<size_t>(match.index)];
+        results.emplace_back(match.score, choice.index, choice.val);
+    }
+
+    return results;
+}
+
+/**
+ * @brief builds a BK-tree over the choices of a Corpus. None is not inserted
+ */
+static inline void build_bk_tree(BKTree& tree, const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                 RF_Scorer* scorer, const std::vector<RF_StringWrapper>& choices)
+{
+    if ((scorer_flags->flags & RF_SCORER_FLAG_TRIANGLE_INEQUALITY) != RF_SCORER_FLAG_TRIANGLE_INEQUALITY ||
+        !(scorer_flags->flags & RF_SCORER_FLAG_RESULT_I64))
+        throw std::invalid_argument("BK-tree requires a distance adhering to the triangle inequality");
+
+    tree.clear();
+    run_parallel(1, static_cast<int64_t>(choices.size()), 1024, [&](int64_t row, int64_t row_end) {
+        for (; row < row_end; ++row) {
+            const RF_StringWrapper& choice = choices[static_cast<size_t>(row)];
+            if (choice.is_none()) continue;
+
+            RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &choice.string);
+            tree.insert(row, [&](int64_t node_index) {
+                int64_t dist;
+                ScorerFunc.call(&choices[static_cast<size_t>(node_index)].string,
+                                std::numeric_limits<int64_t>::max(), 0, &dist);
+                return dist;
+            });
+        }
+    });
+}
+
+/**
+ * @brief extract the best `limit` matches using a BK-tree. The score_cutoff of ExtractTopK is
+ * used as radius, so this is a radius search, which turns into a k-nearest neighbour search
+ * once `limit` matches are found.
+ */
+static inline std::vector<IndexMatchElem<int64_t>>
+extract_bk_tree_impl(const BKTree& tree, const RF_Kwargs* kwargs, const RF_ScorerFlags* scorer_flags,
+                     RF_Scorer* scorer, const RF_StringWrapper& query,
+                     const std::vector<RF_StringWrapper>& choices, int64_t score_cutoff, int64_t score_hint,
+                     int64_t limit)
+{
+    if (limit <= 0) return {};
+
+    ExtractTopK<int64_t> results(scorer_flags, limit, score_cutoff);
+    run_parallel(1, 1, 1, [&](int64_t, int64_t) {
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &query.string);
+        tree.search(
+            [&](int64_t index, int64_t max_distance) {
+                int64_t dist;
+                ScorerFunc.call(&choices[static_cast<size_t>(index)].string, max_distance, score_hint, &dist);
+                return dist;
+            },
+            [&] {
+                return results.score_cutoff();
+            },
+            [&](int64_t index, int64_t dist) {
+                results.push(dist, index);
+            });
+    });
+    return results.take_sorted();
+}
+
+/**
+ * @brief extract using choices which were already preprocessed by a Corpus. Choices
+ * which are None are stored as empty RF_StringWrapper. The index of the matches is
+ * the position inside the Corpus. `bk_tree` is only passed when it was built using
+ * the same scorer. `signatures` are the character signatures and `length_buckets` the choices
+ * grouped by length stored by the Corpus.
+ */
+template <typename T>
+std::vector<IndexMatchElem<T>> extract_corpus_impl(const RF_Kwargs* kwargs,
+                                                   const RF_ScorerFlags* scorer_flags, RF_Scorer* scorer,
+                                                   const RF_StringWrapper& query,
+                                                   const std::vector<RF_StringWrapper>& choices,
+                                                   const QGramIndex& qgram_index, const BKTree* bk_tree,
+                                                   const CharSignatures* signatures,
+                                                   const LengthBuckets* length_buckets, T score_cutoff,
+                                                   T score_hint, int64_t limit, int workers)
+{
+    if (bk_tree) {
+        if constexpr (std::is_same<T, int64_t>::value)
+            return extract_bk_tree_impl(*bk_tree, kwargs, scorer_flags, scorer, query, choices, score_cutoff,
+                                        score_hint, limit);
+        else
+            throw std::invalid_argument("BK-tree requires a distance adhering to the triangle inequality");
+    }
+
+    /* with a q-gram index only the choices sharing enough q-grams with the query are scored */
+    if (!qgram_index.empty() && (scorer_flags->flags & RF_SCORER_FLAG_LCS_BOUND) && !query.is_none()) {
+        std::vector<int64_t> candidates;
+        bool filtered = false;
+        run_parallel(1, 1, 1, [&](int64_t, int64_t) {
+            RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &query.string);
+            std::vector<int64_t> min_shared =
+                qgram_min_shared(qgram_index, ScorerFunc, query.string, score_cutoff, score_hint,
+                                 is_lowest_score_worst<T>(scorer_flags));
+
+            filtered = std::any_of(min_shared.begin(), min_shared.end(), [](int64_t required) {
+                return required > QGramIndex::all_candidates;
+            });
+            if (filtered) candidates = qgram_index.candidates(query.string, min_shared);
+        });
+
+        if (filtered) {
+            auto matches = extract_index_impl<T>(
+                kwargs, scorer_flags, scorer, query, static_cast<int64_t>(candidates.size()),
+                [&](int64_t i) -> const RF_StringWrapper& {
+                    return choices[static_cast<size_t>(candidates[static_cast<size_t>(i)])];
+                },
+                limit, score_cutoff, score_hint, workers);
+
+            for (auto& match : matches)
+                match.index = candidates[static_cast<size_t>(match.index)];
+            return matches;
+        }
+    }
+
+    return extract_index_impl<T>(
+        kwargs, scorer_flags, scorer, query, static_cast<int64_t>(choices.size()),
+        [&](int64_t i) -> const RF_StringWrapper& {
+            return choices[static_cast<size_t>(i)];
+        },
+        limit, score_cutoff, score_hint, workers, signatures, length_buckets);
+}
+
+int64_t any_round(double score)
+{
+    return std::llround(score);
+}
+
+int64_t any_round(int64_t score)
+{
+    return score;
+}
+
+enum class MatrixType {
+    UNDEFINED,
+    FLOAT32,
+    FLOAT64,
+    INT8,
+    INT16,
+    INT32,
+    INT64,
+    UINT8,
+    UINT16,
+    UINT32,
+    UINT64,
+};
+
+struct Matrix {
+    MatrixType m_dtype;
+    size_t m_rows;
+    size_t m_cols;
+    void* m_matrix;
+    /* strides in bytes. Matrices viewing a buffer of the caller can be strided */
+    int64_t m_row_stride;
+    int64_t m_col_stride;
+    bool m_owns_data;
+
+    Matrix()
+        : m_dtype(MatrixType::FLOAT32),
+          m_rows(0),
+          m_cols(0),
+          m_matrix(nullptr),
+          m_row_stride(0),
+          m_col_stride(0),
+          m_owns_data(false)
+    {}
+
+    Matrix(MatrixType dtype, size_t rows, size_t cols)
+        : m_dtype(dtype), m_rows(rows), m_cols(cols), m_owns_data(true)
+    {
+        m_col_stride = get_dtype_size();
+        m_row_stride = static_cast<int64_t>(m_cols) * m_col_stride;
+
+        /* empty matrices still get a valid pointer, since it is passed to numpy */
+        m_matrix = malloc(std::max<size_t>(get_dtype_size() * m_rows * m_cols, 1));
+        if (m_matrix == nullptr) throw std::bad_alloc();
+    }
+
+    /**
+     * @brief view of a buffer owned by the caller (e.g. the out argument of cdist), which is
+     * written in place. The buffer has to stay alive as long as the matrix is used.
+     */
+    Matrix(MatrixType dtype, size_t rows, size_t cols, void* data, int64_t row_stride, int64_t col_stride)
+        : m_dtype(dtype),
+          m_rows(rows),
+          m_cols(cols),
+          m_matrix(data),
+          m_row_stride(row_stride),
+          m_col_stride(col_stride),
+          m_owns_data(false)
+    {}
+
+    Matrix(const Matrix& other) : Matrix(other.m_dtype, other.m_rows, other.m_cols)
+    {
+        size_t dtype_size = static_cast<size_t>(get_dtype_size());
+        for (size_t row = 0; row < m_rows; ++row)
+            for (size_t col = 0; col < m_cols; ++col)
+                memcpy(get_ptr(row, col), other.get_ptr(row, col), dtype_size);
+    }
+
+    Matrix(Matrix&& other) noexcept : Matrix()
+    {
+        other.swap(*this);
+    }
+
+    Matrix& operator=(Matrix other)
+    {
+        other.swap(*this);
+        return *this;
+    }
+
+    void swap(Matrix& rhs) noexcept
+    {
+        using std::swap;
+        swap(m_rows, rhs.m_rows);
+        swap(m_cols, rhs.m_cols);
+        swap(m_dtype, rhs.m_dtype);
+        swap(m_matrix, rhs.m_matrix);
+        swap(m_row_stride, rhs.m_row_stride);
+        swap(m_col_stride, rhs.m_col_stride);
+        swap(m_owns_data, rhs.m_owns_data);
+    }
+
+    ~Matrix()
+    {
+        if (m_owns_data) free(m_matrix);
+    }
+
+    char* get_ptr(size_t row, size_t col) const
+    {
+        return static_cast<char*>(m_matrix) + static_cast<int64_t>(row) * m_row_stride +
+               static_cast<int64_t>(col) * m_col_stride;
+    }
+
+    int get_dtype_size()
+    {
+        switch (m_dtype) {
+        case MatrixType::FLOAT32: return 4;
+        case MatrixType::FLOAT64: return 8;
+        case MatrixType::INT8: return 1;
+        case MatrixType::INT16: return 2;
+        case MatrixType::INT32: return 4;
+        case MatrixType::INT64: return 8;
+        case MatrixType::UINT8: return 1;
+        case MatrixType::UINT16: return 2;
+        case MatrixType::UINT32: return 4;
+        case MatrixType::UINT64: return 8;
+        default: throw std::invalid_argument("invalid dtype");
+        }
+    }
+
+    const char* get_format()
+    {
+        switch (m_dtype) {
+        case MatrixType::FLOAT32: return "f";
+        case MatrixType::FLOAT64: return "d";
+        case MatrixType::INT8: return "b";
+        case MatrixType::INT16: return "h";
+        case MatrixType::INT32: return "i";
+        case MatrixType::INT64: return "q";
+        case MatrixType::UINT8: return "B";
+        case MatrixType::UINT16: return "H";
+        case MatrixType::UINT32: return "I";
+        case MatrixType::UINT64: return "Q";
+        default: throw std::invalid_argument("invalid dtype");
+        }
+    }
+
+    template <typename T>
+    void set(size_t row, size_t col, T score)
+    {
+        void* data = get_ptr(row, col);
+        switch (m_dtype) {
+        case MatrixType::FLOAT32: *((float*)data) = (float)score; break;
+        case MatrixType::FLOAT64: *((double*)data) = (double)score; break;
+        case MatrixType::INT8: *((int8_t*)data) = (int8_t)any_round(score); break;
+        case MatrixType::INT16: *((int16_t*)data) = (int16_t)any_round(score); break;
+        case MatrixType::INT32: *((int32_t*)data) = (int32_t)any_round(score); break;
+        case MatrixType::INT64: *((int64_t*)data) = any_round(score); break;
+        case MatrixType::UINT8: *((uint8_t*)data) = (uint8_t)any_round(score); break;
+        case MatrixType::UINT16: *((uint16_t*)data) = (uint16_t)any_round(score); break;
+        case MatrixType::UINT32: *((uint32_t*)data) = (uint32_t)any_round(score); break;
+        case MatrixType::UINT64: *((uint64_t*)data) = (uint64_t)any_round(score); break;
+        default: assert(false); break;
+        }
+    }
+};
+
+template <typename OutT, typename T>
+static inline OutT convert_score(T score)
+{
+    if constexpr (std::is_floating_point<OutT>::value)
+        return static_cast<OutT>(score);
+    else
+        return static_cast<OutT>(any_round(score));
+}
+
+/**
+ * @brief `score` clamped to the range of the integer type OutT, so a score beyond it stays at the
+ * same end of the range after the conversion instead of wrapping around
+ */
+template <typename OutT, typename T>
+static inline T saturate_score_to(T score)
+{
+    if constexpr (std::is_integral<OutT>::value) {
+        using Limits = std::numeric_limits<OutT>;
+        /* the maximum of 64 bit types is above all scores of integer scorers */
+        if constexpr (sizeof(OutT) < sizeof(int64_t)) score = std::min(score, static_cast<T>(Limits::max()));
+        score = std::max(score, static_cast<T>(Limits::min()));
+    }
+    return score;
+}
+
+/**
+ * @brief `score` clamped to the range of dtype. cdist_topk pads rows with the worst score saturated
+ * this way, so e.g. the worst score of distances stays the worst score for dtype=np.int32
+ */
+template <typename T>
+static inline T saturate_score(T score, MatrixType dtype)
+{
+    switch (dtype) {
+    case MatrixType::INT8: return saturate_score_to<int8_t>(score);
+    case MatrixType::INT16: return saturate_score_to<int16_t>(score);
+    case MatrixType::INT32: return saturate_score_to<int32_t>(score);
+    case MatrixType::INT64: return saturate_score_to<int64_t>(score);
+    case MatrixType::UINT8: return saturate_score_to<uint8_t>(score);
+    case MatrixType::UINT16: return saturate_score_to<uint16_t>(score);
+    case MatrixType::UINT32: return saturate_score_to<uint32_t>(score);
+    case MatrixType::UINT64: return saturate_score_to<uint64_t>(score);
+    default: return score;
+    }
+}
+
+/**
+ * @brief writes scores into a Matrix with the element type OutT. The kernels are instantiated
+ * for each writer, so storing a score is a direct store instead of a switch over the dtype.
+ */
+template <typename OutT>
+struct MatrixWriter {
+    char* m_data;
+    int64_t m_row_stride;
+    int64_t m_col_stride;
+
+    explicit MatrixWriter(Matrix& matrix)
+        : m_data(static_cast<char*>(matrix.m_matrix)),
+          m_row_stride(matrix.m_row_stride),
+          m_col_stride(matrix.m_col_stride)
+    {}
+
+    template <typename T>
+    void set(size_t row, size_t col, T score)
+    {
+        char* elem =
+            m_data + static_cast<int64_t>(row) * m_row_stride + static_cast<int64_t>(col) * m_col_stride;
+        *reinterpret_cast<OutT*>(elem) = convert_score<OutT>(score);
+    }
+};
 
-            size_t len2 = queries[i2].size();
-            if (len2 <= 64)
-                len2 = len2 / 8;
-            else
-                len2 = (64 / 8) + len2 / 64;
+/**
+ * @brief factor the scores of floating point scorers are multiplied with when they are stored
+ * in a uint8 matrix, so they cover the range 0-100. This keeps the scores of the fuzz module
+ * unchanged, while normalized scores are no longer rounded to 0 or 1.
+ */
+template <typename T>
+static inline double uint8_score_scale(const RF_ScorerFlags* scorer_flags)
+{
+    if (!std::is_same<T, double>::value) return 1.0;
 
-            return len1 > len2;
-        });
+    double max_score = std::max(scorer_flags->optimal_score.f64, scorer_flags->worst_score.f64);
+    return (max_score > 0) ? 100.0 / max_score : 1.0;
+}
 
-        size_t smallest_size = queries[row_idx.back()].size();
-        size_t step_size;
-        if (smallest_size <= 8)
-            step_size = 256 / 8;
-        else if (smallest_size <= 16)
-            step_size = 256 / 16;
-        else if (smallest_size <= 32)
-            step_size = 256 / 32;
-        else
-            step_size = 256 / 64;
+/**
+ * @brief writes scores of floating point scorers into a uint8 matrix as 0-100, scaling and
+ * rounding them in a single step
+ */
+struct ScaledUInt8Writer {
+    uint8_t* m_data;
+    int64_t m_row_stride;
+    int64_t m_col_stride;
+    double m_scale;
+
+    ScaledUInt8Writer(Matrix& matrix, double scale)
+        : m_data(static_cast<uint8_t*>(matrix.m_matrix)),
+          m_row_stride(matrix.m_row_stride),
+          m_col_stride(matrix.m_col_stride),
+          m_scale(scale)
+    {}
 
-        run_parallel(workers, row_idx.size(), step_size, [&](int64_t row, int64_t row_end) {
-            /* todo add simd support for long sequences */
-            for (; row < row_end; ++row) {
-                if (queries[row_idx[row]].size() <= 64) break;
+    template <typename T>
+    void set(size_t row, size_t col, T score)
+    {
+        m_data[static_cast<int64_t>(row) * m_row_stride + static_cast<int64_t>(col) * m_col_stride] =
+            static_cast<uint8_t>(std::llround(static_cast<double>(score) * m_scale));
+    }
+};
 
-                RF_ScorerFunc scorer_func;
-                PyErr2RuntimeExn(
-                    scorer->scorer_func_init(&scorer_func, kwargs, 1, &queries[row_idx[row]].string));
-                RF_ScorerWrapper ScorerFunc(scorer_func);
+/**
+ * @brief calls `func` with the writer matching the dtype of the matrix
+ */
+template <typename T, typename Func>
+static void visit_matrix_writer(Matrix& matrix, const RF_ScorerFlags* scorer_flags, Func&& func)
+{
+    switch (matrix.m_dtype) {
+    case MatrixType::FLOAT32: {
+        MatrixWriter<float> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::FLOAT64: {
+        MatrixWriter<double> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::INT8: {
+        MatrixWriter<int8_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::INT16: {
+        MatrixWriter<int16_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::INT32: {
+        MatrixWriter<int32_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::INT64: {
+        MatrixWriter<int64_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::UINT8: {
+        if (std::is_same<T, double>::value) {
+            ScaledUInt8Writer writer(matrix, uint8_score_scale<T>(scorer_flags));
+            return func(writer);
+        }
+        MatrixWriter<uint8_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::UINT16: {
+        MatrixWriter<uint16_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::UINT32: {
+        MatrixWriter<uint32_t> writer(matrix);
+        return func(writer);
+    }
+    case MatrixType::UINT64: {
+        MatrixWriter<uint64_t> writer(matrix);
+        return func(writer);
+    }
+    default: throw std::invalid_argument("invalid dtype");
+    }
+}
 
-                for (int64_t col = 0; col < cols; ++col) {
-                    T score;
-                    if (choices[col].is_none())
-                        score = worst_score;
-                    else
-                        ScorerFunc.call(&choices[col].string, score_cutoff, score_hint, &score);
+/**
+ * @brief smallest SIMD width supported by the multi string scorers a string of the given
+ * length fits into. Scorers setting RF_SCORER_FLAG_MULTI_STRING_LONG store strings longer
+ * than 64 characters in lanes of several 64 bit words. Returns 0 for strings, which are too
+ * long for them
+ */
+static inline size_t multi_string_width(size_t len, bool long_strings)
+{
+    if (len <= 8) return 8;
+    if (len <= 16) return 16;
+    if (len <= 32) return 32;
+    if (len <= 64) return 64;
+    if (!long_strings) return 0;
+    if (len <= 128) return 128;
+    if (len <= 256) return 256;
+    return 0;
+}
+
+/**
+ * @brief number of strings scored by a single multi string scorer. Up to 64 characters
+ * they fill a 256 bit vector, while longer strings are processed in groups of 8 lanes
+ */
+static inline size_t multi_string_block_size(size_t width)
+{
+    return (width <= 64) ? 256 / width : 8;
+}
+
+/**
+ * @brief estimated cost of scoring strings against each other, which is used to balance the work
+ * between the workers. `strings_cost` is the cost of the strings passed to the scorer, while
+ * the cost factors account for the length of the string the scorer was initialized with.
+ */
+static inline int64_t strings_cost(const std::vector<RF_StringWrapper>& strings)
+{
+    int64_t cost = 0;
+    for (const auto& str : strings)
+        if (!str.is_none()) cost += static_cast<int64_t>(str.size()) + 1;
+
+    return cost;
+}
+
+/* the bit-parallel scorers process 64 characters of the query per word */
+static inline int64_t scalar_cost_factor(size_t len)
+{
+    return static_cast<int64_t>(len / 64 + 1);
+}
+
+/* up to 64 characters a block fits into one vector, longer strings use 8 lanes of width / 64 words */
+static inline int64_t block_cost_factor(size_t width)
+{
+    return static_cast<int64_t>(width <= 64 ? 1 : width / 32);
+}
+
+/**
+ * @brief strings grouped into blocks, which are passed to a multi string scorer at once.
+ * All strings in a block fall into the same SIMD width, so the block size can be chosen
+ * per block and no block is slowed down by a single long string.
+ */
+struct MultiStringBlocks {
+    /* indices of all strings, which are not None. Sorted by descending SIMD width */
+    std::vector<size_t> indices;
+    /* indices[0, long_count) are too long for the multi string scorers */
+    size_t long_count = 0;
+    /* ranges in indices, which are scored using a single multi string scorer */
+    std::vector<std::pair<size_t, size_t>> blocks;
+};
+
+static inline MultiStringBlocks multi_string_blocks(const std::vector<RF_StringWrapper>& strings,
+                                                    bool long_strings)
+{
+    MultiStringBlocks res;
+    for (size_t i = 0; i < strings.size(); ++i)
+        if (!strings[i].is_none()) res.indices.push_back(i);
+
+    auto width = [&](size_t i) {
+        size_t w = multi_string_width(strings[i].size(), long_strings);
+        return w ? w : std::numeric_limits<size_t>::max();
+    };
+
+    /* long strings first, since they take the longest to process */
+    std::stable_sort(res.indices.begin(), res.indices.end(), [&](size_t i1, size_t i2) {
+        return width(i1) > width(i2);
+    });
+
+    while (res.long_count < res.indices.size() &&
+           !multi_string_width(strings[res.indices[res.long_count]].size(), long_strings))
+        res.long_count++;
+
+    for (size_t begin = res.long_count; begin < res.indices.size();) {
+        size_t block_width = width(res.indices[begin]);
+        size_t block_end = std::min(begin + multi_string_block_size(block_width), res.indices.size());
+        size_t end = begin + 1;
+        while (end < block_end && width(res.indices[end]) == block_width)
+            end++;
+
+        res.blocks.emplace_back(begin, end);
+        begin = end;
+    }
+
+    return res;
+}
+
+/**
+ * @brief scores the strings `get_string(i)` for i in [begin, end) with the same score_cutoff.
+ * The strings are passed to the scorer in batches and `store(i, scores)` is called with the
+ * `result_count` results of each of them. None and the strings `skip(i)` returns true for
+ * are skipped.
+ */
+template <typename T, typename StringFunc, typename StoreFunc, typename SkipFunc>
+static void score_batched(const RF_ScorerWrapper& ScorerFunc, size_t begin, size_t end,
+                          StringFunc&& get_string, T score_cutoff, T score_hint, size_t result_count,
+                          StoreFunc&& store, SkipFunc&& skip)
+{
+    assert(result_count <= 256 / 8);
+    RF_String strings[score_batch_size];
+    size_t indices[score_batch_size];
+    T score_cutoffs[score_batch_size];
+    T scores[score_batch_size * (256 / 8)];
+    std::fill(score_cutoffs, score_cutoffs + score_batch_size, score_cutoff);
+
+    while (begin < end) {
+        int64_t batch_count = 0;
+        for (; begin < end && batch_count < score_batch_size; ++begin) {
+            const RF_StringWrapper& str = get_string(begin);
+            if (str.is_none() || skip(begin)) continue;
+
+            strings[batch_count] = str.string;
+            indices[batch_count] = begin;
+            ++batch_count;
+        }
+
+        ScorerFunc.call_batch(strings, batch_count, score_cutoffs, score_hint, scores, result_count);
+        for (int64_t k = 0; k < batch_count; ++k)
+            store(indices[k], scores + static_cast<size_t>(k) * result_count);
+    }
+}
+
+template <typename T, typename StringFunc, typename StoreFunc>
+static void score_batched(const RF_ScorerWrapper& ScorerFunc, size_t begin, size_t end,
+                          StringFunc&& get_string, T score_cutoff, T score_hint, size_t result_count,
+                          StoreFunc&& store)
+{
+    score_batched<T>(ScorerFunc, begin, end, std::forward<StringFunc>(get_string), score_cutoff, score_hint,
+                     result_count, std::forward<StoreFunc>(store), [](size_t) {
+                         return false;
+                     });
+}
+
+/**
+ * @brief scores the lower triangle of the matrix (in the order of blocks.indices) and mirrors
+ * it. The queries are scored in units, which are either a single query too long for the
+ * multi string scorers or a block of queries. Each unit compares its queries to all queries
+ * up to the end of the unit. These ranges are split into tiles of a similar number of
+ * scorer calls, so short and long rows of the triangle are distributed evenly over the workers.
+ */
+template <typename T, typename Output>
+static void cdist_single_list_run(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                  RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                  int workers, T score_cutoff, T score_hint, T worst_score, Output& matrix)
+{
+    int64_t rows = queries.size();
+    int64_t cols = queries.size();
+    bool multiStringInit = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_INIT;
+    bool multiStringLong = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_LONG;
+
+    for (int64_t row = 0; row < rows; ++row) {
+        if (!queries[row].is_none()) continue;
+
+        for (int64_t col = 0; col < cols; ++col) {
+            matrix.set(row, col, worst_score);
+            matrix.set(col, row, worst_score);
+        }
+    }
 
-                    matrix.set(row_idx[row], col, score);
+    MultiStringBlocks blocks;
+    if (multiStringInit) {
+        blocks = multi_string_blocks(queries, multiStringLong);
+    }
+    else {
+        for (size_t i = 0; i < queries.size(); ++i)
+            if (!queries[i].is_none()) blocks.indices.push_back(i);
+
+        blocks.long_count = blocks.indices.size();
+    }
+
+    /* all elements are None */
+    if (blocks.indices.empty()) return;
+
+    const size_t tile_size = 4096;
+    const size_t unit_count = blocks.long_count + blocks.blocks.size();
+    auto unit_range = [&](size_t unit) {
+        if (unit < blocks.long_count) return std::make_pair(unit, unit + 1);
+        return blocks.blocks[unit - blocks.long_count];
+    };
+
+    /* first tile of each unit */
+    std::vector<int64_t> unit_tiles(unit_count + 1, 0);
+    for (size_t unit = 0; unit < unit_count; ++unit) {
+        size_t range_end = unit_range(unit).second;
+        unit_tiles[unit + 1] =
+            unit_tiles[unit] + static_cast<int64_t>((range_end + tile_size - 1) / tile_size);
+    }
+
+    auto score_long_row = [&](size_t pos, size_t begin, size_t end) {
+        size_t row = blocks.indices[pos];
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &queries[row].string);
+
+        score_batched(
+            ScorerFunc, begin, end,
+            [&](size_t i) -> const RF_StringWrapper& {
+                return queries[blocks.indices[i]];
+            },
+            score_cutoff, score_hint, 1, [&](size_t i, const T* score) {
+                size_t col = blocks.indices[i];
+                matrix.set(row, col, *score);
+                matrix.set(col, row, *score);
+            });
+    };
+
+    auto score_block = [&](size_t block_begin, size_t block_end, size_t begin, size_t end) {
+        int64_t row_count = static_cast<int64_t>(block_end - block_begin);
+        assert(row_count <= 256 / 8);
+        RF_String strings[256 / 8];
+
+        for (int64_t k = 0; k < row_count; ++k)
+            strings[k] = queries[blocks.indices[block_begin + k]].string;
+
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, row_count, strings);
+
+        score_batched(
+            ScorerFunc, begin, end,
+            [&](size_t i) -> const RF_StringWrapper& {
+                return queries[blocks.indices[i]];
+            },
+            score_cutoff, score_hint, static_cast<size_t>(row_count), [&](size_t i, const T* scores) {
+                size_t col = blocks.indices[i];
+                /* inside the block only the lower triangle is written, so each element has a single writer */
+                for (size_t pos = std::max(block_begin, i); pos < block_end; ++pos) {
+                    size_t row = blocks.indices[pos];
+                    matrix.set(row, col, scores[pos - block_begin]);
+                    matrix.set(col, row, scores[pos - block_begin]);
                 }
-            }
+            });
+    };
+
+    /* the tiles of a unit have a similar number of scorer calls, but their cost still depends
+     * on the length of the strings */
+    std::vector<int64_t> len_prefix(blocks.indices.size() + 1, 0);
+    for (size_t i = 0; i < blocks.indices.size(); ++i)
+        len_prefix[i + 1] = len_prefix[i] + static_cast<int64_t>(queries[blocks.indices[i]].size()) + 1;
+
+    std::vector<int64_t> tile_costs;
+    tile_costs.reserve(static_cast<size_t>(unit_tiles.back()));
+    for (size_t unit = 0; unit < unit_count; ++unit) {
+        auto range = unit_range(unit);
+        size_t len = queries[blocks.indices[range.first]].size();
+        int64_t factor = (unit < blocks.long_count)
+                             ? scalar_cost_factor(len)
+                             : block_cost_factor(multi_string_width(len, multiStringLong));
+
+        for (size_t begin = 0; begin < range.second; begin += tile_size) {
+            size_t end = std::min(begin + tile_size, range.second);
+            tile_costs.push_back(factor * (len_prefix[end] - len_prefix[begin]));
+        }
+    }
+
+    run_parallel_balanced(workers, tile_costs, [&](int64_t tile, int64_t tile_end) {
+        for (; tile < tile_end; ++tile) {
+            size_t unit = static_cast<size_t>(
+                std::upper_bound(unit_tiles.begin(), unit_tiles.end(), tile) - unit_tiles.begin() - 1);
+            auto range = unit_range(unit);
+            size_t begin = static_cast<size_t>(tile - unit_tiles[unit]) * tile_size;
+            size_t end = std::min(begin + tile_size, range.second);
+
+            if (unit < blocks.long_count)
+                score_long_row(range.first, begin, end);
+            else
+                score_block(range.first, range.second, begin, end);
+        }
+    });
+}
+
+/**
+ * @brief fills a queries.size() x queries.size() matrix in place. The matrix can be a strided
+ * view of a buffer provided by the caller.
+ */
+template <typename T>
+static void cdist_single_list_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                   RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                   Matrix& matrix, int workers, T score_cutoff, T score_hint, T worst_score)
+{
+    if (matrix.m_rows != queries.size() || matrix.m_cols != queries.size())
+        throw std::invalid_argument("matrix has the wrong shape");
+
+    visit_matrix_writer<T>(matrix, scorer_flags, [&](auto& writer) {
+        cdist_single_list_run<T>(scorer_flags, kwargs, scorer, queries, workers, score_cutoff, score_hint,
+                                 worst_score, writer);
+    });
+}
+
+template <typename T>
+static Matrix cdist_single_list_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                     RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                     MatrixType dtype, int workers, T score_cutoff, T score_hint,
+                                     T worst_score)
+{
+    Matrix matrix(dtype, queries.size(), queries.size());
+    cdist_single_list_impl<T>(scorer_flags, kwargs, scorer, queries, matrix, workers, score_cutoff,
+                              score_hint, worst_score);
+    return matrix;
+}
+
+/**
+ * @brief tile sizes of the cache blocked traversal in cdist. Each task scores up to `query_units`
+ * queries (or blocks of queries for the multi string scorers) against the choices one tile at a
+ * time. A tile holds about `choice_tile_bytes` of strings, so it stays in the L2 cache while all
+ * scorers of the task are applied to it instead of streaming all choices once per query.
+ */
+struct CdistTiling {
+    size_t choice_tile_bytes = 256 * 1024;
+    size_t query_units = 16;
+};
+
+/**
+ * @brief bounds of the tiles the choices are split into
+ */
+static inline std::vector<size_t> choice_tiles(const std::vector<RF_StringWrapper>& choices,
+                                               size_t tile_bytes)
+{
+    std::vector<size_t> bounds = {0};
+    size_t bytes = 0;
+    for (size_t col = 0; col < choices.size(); ++col) {
+        const RF_String& str = choices[col].string;
+        bytes += sizeof(RF_StringWrapper) + static_cast<size_t>(str.length) * (size_t(1) << str.kind);
+        if (bytes >= tile_bytes) {
+            bounds.push_back(col + 1);
+            bytes = 0;
+        }
+    }
+    if (bounds.back() != choices.size()) bounds.push_back(choices.size());
+
+    return bounds;
+}
 
-            int64_t row_count = row_end - row;
-            if (row_count == 0) return;
+/**
+ * @brief scores all queries against all choices and passes the results to `output.set(row, col, score)`.
+ * Each row is only written by a single task, so the output does not need to synchronize
+ * writes to different rows.
+ */
+template <typename T, typename Output>
+static void cdist_two_lists_run(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                const std::vector<RF_StringWrapper>& choices, int workers, T score_cutoff,
+                                T score_hint, T worst_score, Output& matrix,
+                                const CdistTiling& tiling = CdistTiling())
+{
+    int64_t rows = queries.size();
+    int64_t cols = choices.size();
+    bool multiStringInit = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_INIT;
+    bool multiStringLong = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_LONG;
+
+    if (queries.empty() || choices.empty()) return;
+
+    for (int64_t row = 0; row < rows; ++row)
+        if (queries[row].is_none())
+            for (int64_t col = 0; col < cols; ++col)
+                matrix.set(row, col, worst_score);
+
+    MultiStringBlocks row_blocks;
+    if (multiStringInit) {
+        row_blocks = multi_string_blocks(queries, multiStringLong);
+    }
+    else {
+        for (size_t i = 0; i < queries.size(); ++i)
+            if (!queries[i].is_none()) row_blocks.indices.push_back(i);
+
+        /* longest queries first, since they take the longest to process */
+        std::stable_sort(row_blocks.indices.begin(), row_blocks.indices.end(), [&](size_t i1, size_t i2) {
+            return queries[i1].size() > queries[i2].size();
+        });
+        row_blocks.long_count = row_blocks.indices.size();
+    }
+
+    /* all elements are None */
+    if (row_blocks.indices.empty()) return;
+
+    /* queries, which are too long for the multi string scorers, can still make use of them
+     * for symmetric scorers by initializing the multi string scorer with the choices instead */
+    bool transpose_long = multiStringInit && row_blocks.long_count &&
+                          (scorer_flags->flags & RF_SCORER_FLAG_SYMMETRIC);
+    MultiStringBlocks col_blocks;
+    if (transpose_long) col_blocks = multi_string_blocks(choices, multiStringLong);
+
+    /* group long queries, so the multi string scorers for the choices are reused */
+    const size_t long_step = 8;
+    const size_t transposed_tasks = transpose_long ? (row_blocks.long_count + long_step - 1) / long_step : 0;
+
+    /* the remaining queries are scored in units of a single long query or a block of queries */
+    const size_t long_units = transpose_long ? 0 : row_blocks.long_count;
+    const size_t unit_count = long_units + row_blocks.blocks.size();
+    auto unit_range = [&](size_t unit) {
+        if (unit < long_units) return std::make_pair(unit, unit + 1);
+        return row_blocks.blocks[unit - long_units];
+    };
 
+    /* keep enough tasks to distribute the units over the workers */
+    size_t worker_count = (workers < 0) ? std::thread::hardware_concurrency() : static_cast<size_t>(workers);
+    size_t units_per_task = unit_count / (std::max<size_t>(worker_count, 1) * 4);
+    units_per_task = std::min(std::max<size_t>(units_per_task, 1), std::max<size_t>(tiling.query_units, 1));
+    const size_t unit_tasks = (unit_count + units_per_task - 1) / units_per_task;
+
+    /* queries scored on their own reject choices based on their character signature. The blocks of
+     * the multi string scorers score a choice against all of their queries at once, which is
+     * cheaper than checking the signature for each of them */
+    CharSignatures choice_signatures;
+    if ((scorer_flags->flags & RF_SCORER_FLAG_LCS_BOUND) && long_units && score_cutoff != worst_score)
+        choice_signatures.build(choices);
+    bool lowest_score_worst = is_lowest_score_worst<T>(scorer_flags);
+    const T reject_score = rejected_score(score_cutoff, worst_score, lowest_score_worst);
+
+    const std::vector<size_t> col_tiles = choice_tiles(choices, tiling.choice_tile_bytes);
+    const int64_t choices_cost = strings_cost(choices);
+    int64_t col_blocks_factor = 0;
+    int64_t long_cols_cost = 0;
+    if (transpose_long) {
+        for (const auto& block : col_blocks.blocks)
+            col_blocks_factor += block_cost_factor(
+                multi_string_width(choices[col_blocks.indices[block.first]].size(), multiStringLong));
+
+        for (size_t k = 0; k < col_blocks.long_count; ++k)
+            long_cols_cost += static_cast<int64_t>(choices[col_blocks.indices[k]].size()) + 1;
+    }
+
+    std::vector<int64_t> task_costs(transposed_tasks + unit_tasks, 0);
+    for (size_t task = 0; task < transposed_tasks; ++task) {
+        size_t end = std::min((task + 1) * long_step, row_blocks.long_count);
+        for (size_t i = task * long_step; i < end; ++i) {
+            size_t len = queries[row_blocks.indices[i]].size();
+            task_costs[task] +=
+                static_cast<int64_t>(len + 1) * col_blocks_factor + scalar_cost_factor(len) * long_cols_cost;
+        }
+    }
+    for (size_t unit = 0; unit < unit_count; ++unit) {
+        size_t len = queries[row_blocks.indices[unit_range(unit).first]].size();
+        int64_t factor = (unit < long_units) ? scalar_cost_factor(len)
+                                             : block_cost_factor(multi_string_width(len, multiStringLong));
+        task_costs[transposed_tasks + unit / units_per_task] += factor * choices_cost;
+    }
+
+    /* the choices, which are too long for the multi string scorers as well */
+    auto score_long_rows_long_cols = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t row = row_blocks.indices[i];
+            RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &queries[row].string);
+
+            score_batched(
+                ScorerFunc, 0, col_blocks.long_count,
+                [&](size_t k) -> const RF_StringWrapper& {
+                    return choices[col_blocks.indices[k]];
+                },
+                score_cutoff, score_hint, 1, [&](size_t k, const T* score) {
+                    matrix.set(row, col_blocks.indices[k], *score);
+                });
+        }
+    };
+
+    auto score_long_rows_transposed = [&](size_t begin, size_t end) {
+        for (int64_t col = 0; col < cols; ++col)
+            if (choices[col].is_none())
+                for (size_t i = begin; i < end; ++i)
+                    matrix.set(row_blocks.indices[i], col, worst_score);
+
+        if (col_blocks.long_count) score_long_rows_long_cols(begin, end);
+
+        RF_String strings[256 / 8];
+        for (const auto& block : col_blocks.blocks) {
+            int64_t col_count = static_cast<int64_t>(block.second - block.first);
+            for (int64_t k = 0; k < col_count; ++k)
+                strings[k] = choices[col_blocks.indices[block.first + k]].string;
+
+            RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, col_count, strings);
+
+            score_batched(
+                ScorerFunc, begin, end,
+                [&](size_t i) -> const RF_StringWrapper& {
+                    return queries[row_blocks.indices[i]];
+                },
+                score_cutoff, score_hint, static_cast<size_t>(col_count), [&](size_t i, const T* scores) {
+                    for (int64_t k = 0; k < col_count; ++k)
+                        matrix.set(row_blocks.indices[i], col_blocks.indices[block.first + k], scores[k]);
+                });
+        }
+    };
+
+    auto score_units = [&](size_t unit_begin, size_t unit_end) {
+        std::vector<RF_ScorerWrapper> scorers;
+        scorers.reserve(unit_end - unit_begin);
+        for (size_t unit = unit_begin; unit < unit_end; ++unit) {
+            auto range = unit_range(unit);
+            int64_t row_count = static_cast<int64_t>(range.second - range.first);
             assert(row_count <= 256 / 8);
-            T scores[256 / 8];
             RF_String strings[256 / 8];
-
             for (int64_t i = 0; i < row_count; ++i)
-                strings[i] = queries[row_idx[row + i]].string;
+                strings[i] = queries[row_blocks.indices[range.first + static_cast<size_t>(i)]].string;
 
-            RF_ScorerFunc scorer_func;
-            PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, row_count, strings));
-            RF_ScorerWrapper ScorerFunc(scorer_func);
+            scorers.push_back(init_scorer_func(scorer, kwargs, row_count, strings));
+        }
 
-            for (int64_t col = 0; col < cols; ++col) {
-                if (choices[col].is_none()) {
-                    for (int64_t i = 0; i < row_count; ++i)
-                        scores[i] = worst_score;
-                }
-                else {
-                    ScorerFunc.call(&choices[col].string, score_cutoff, score_hint, scores);
-                }
+        /* the units of single long queries come first */
+        std::vector<CharSignatureFilter<T>> filters;
+        if (choice_signatures.built()) {
+            filters.reserve(std::min(unit_end, long_units) - std::min(unit_begin, long_units));
+            for (size_t unit = unit_begin; unit < std::min(unit_end, long_units); ++unit)
+                filters.emplace_back(choice_signatures, queries[row_blocks.indices[unit]].string,
+                                     scorers[unit - unit_begin], score_cutoff, score_hint,
+                                     lowest_score_worst);
+        }
+
+        for (size_t tile = 0; tile + 1 < col_tiles.size(); ++tile) {
+            for (size_t unit = unit_begin; unit < unit_end; ++unit) {
+                auto range = unit_range(unit);
+                size_t row_count = range.second - range.first;
+                const RF_ScorerWrapper& ScorerFunc = scorers[unit - unit_begin];
+
+                for (size_t col = col_tiles[tile]; col < col_tiles[tile + 1]; ++col)
+                    if (choices[col].is_none())
+                        for (size_t i = 0; i < row_count; ++i)
+                            matrix.set(row_blocks.indices[range.first + i], col, worst_score);
+
+                CharSignatureFilter<T>* filter =
+                    (unit - unit_begin < filters.size()) ? &filters[unit - unit_begin] : nullptr;
+                score_batched(
+                    ScorerFunc, col_tiles[tile], col_tiles[tile + 1],
+                    [&](size_t col) -> const RF_StringWrapper& {
+                        return choices[col];
+                    },
+                    score_cutoff, score_hint, row_count,
+                    [&](size_t col, const T* scores) {
+                        for (size_t i = 0; i < row_count; ++i)
+                            matrix.set(row_blocks.indices[range.first + i], col, scores[i]);
+                    },
+                    [&](size_t col) {
+                        if (!filter || !filter->rejects(col)) return false;
+
+                        matrix.set(row_blocks.indices[range.first], col, reject_score);
+                        return true;
+                    });
+            }
+        }
+    };
 
-                for (int64_t i = 0; i < row_count; ++i)
-                    matrix.set(row_idx[row + i], col, scores[i]);
+    run_parallel_balanced(workers, task_costs, [&](int64_t task, int64_t task_end) {
+        for (size_t t = static_cast<size_t>(task); t < static_cast<size_t>(task_end); ++t) {
+            if (t < transposed_tasks) {
+                score_long_rows_transposed(t * long_step,
+                                           std::min((t + 1) * long_step, row_blocks.long_count));
             }
+            else {
+                size_t unit_begin = (t - transposed_tasks) * units_per_task;
+                score_units(unit_begin, std::min(unit_begin + units_per_task, unit_count));
+            }
+        }
+    });
+}
+
+/**
+ * @brief fills a queries.size() x choices.size() matrix in place. The matrix can be a strided
+ * view of a buffer provided by the caller.
+ */
+template <typename T>
+static void cdist_two_lists_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                 RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                 const std::vector<RF_StringWrapper>& choices, Matrix& matrix, int workers,
+                                 T score_cutoff, T score_hint, T worst_score,
+                                 const CdistTiling& tiling = CdistTiling())
+{
+    if (matrix.m_rows != queries.size() || matrix.m_cols != choices.size())
+        throw std::invalid_argument("matrix has the wrong shape");
+
+    visit_matrix_writer<T>(matrix, scorer_flags, [&](auto& writer) {
+        cdist_two_lists_run<T>(scorer_flags, kwargs, scorer, queries, choices, workers, score_cutoff,
+                               score_hint, worst_score, writer, tiling);
+    });
+}
+
+template <typename T>
+static Matrix cdist_two_lists_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                   RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                   const std::vector<RF_StringWrapper>& choices, MatrixType dtype,
+                                   int workers, T score_cutoff, T score_hint, T worst_score,
+                                   const CdistTiling& tiling = CdistTiling())
+{
+    Matrix matrix(dtype, queries.size(), choices.size());
+    cdist_two_lists_impl<T>(scorer_flags, kwargs, scorer, queries, choices, matrix, workers, score_cutoff,
+                            score_hint, worst_score, tiling);
+    return matrix;
+}
+
+/**
+ * @brief result of cdist in compressed sparse row format. The columns and scores of row i
+ * are stored in indices/data[indptr[i]:indptr[i + 1]]
+ */
+struct SparseMatrix {
+    Matrix m_data;
+    Matrix m_indices;
+    Matrix m_indptr;
+};
+
+/**
+ * @brief append buffers for the elements of each row passing the score_cutoff.
+ * Each row is only written by a single task, so no locking is required.
+ */
+template <typename T>
+struct SparseRows {
+    std::vector<std::vector<std::pair<size_t, T>>> m_rows;
+    T m_score_cutoff;
+    bool m_lowest_score_worst;
+
+    SparseRows(size_t rows, T score_cutoff, bool lowest_score_worst)
+        : m_rows(rows), m_score_cutoff(score_cutoff), m_lowest_score_worst(lowest_score_worst)
+    {}
+
+    void set(size_t row, size_t col, T score)
+    {
+        if (score_within_cutoff(score, m_score_cutoff, m_lowest_score_worst))
+            m_rows[row].emplace_back(col, score);
+    }
+};
+
+/**
+ * @brief cdist, which only stores the elements passing the score_cutoff, so the dense
+ * matrix is never allocated
+ */
+template <typename T>
+static SparseMatrix cdist_sparse_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                      RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                      const std::vector<RF_StringWrapper>& choices, MatrixType dtype,
+                                      int workers, T score_cutoff, T score_hint, T worst_score)
+{
+    SparseRows<T> rows(queries.size(), score_cutoff, is_lowest_score_worst<T>(scorer_flags));
+    cdist_two_lists_run<T>(scorer_flags, kwargs, scorer, queries, choices, workers, score_cutoff, score_hint,
+                           worst_score, rows);
+
+    size_t nnz = 0;
+    for (auto& row : rows.m_rows) {
+        /* the transposed multi string scorers do not produce the columns in order */
+        std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
         });
+        nnz += row.size();
     }
-    else {
-        run_parallel(workers, rows, 1, [&](int64_t row, int64_t row_end) {
-            for (; row < row_end; ++row) {
-                RF_ScorerFunc scorer_func;
-                PyErr2RuntimeExn(scorer->scorer_func_init(&scorer_func, kwargs, 1, &queries[row].string));
-                RF_ScorerWrapper ScorerFunc(scorer_func);
-
-                for (int64_t col = 0; col < cols; ++col) {
-                    T score;
-                    if (choices[col].is_none())
-                        score = worst_score;
-                    else
-                        ScorerFunc.call(&choices[col].string, score_cutoff, score_hint, &score);
 
-                    matrix.set(row, col, score);
-                }
+    SparseMatrix res;
+    res.m_data = Matrix(dtype, 1, nnz);
+    res.m_indices = Matrix(MatrixType::INT64, 1, nnz);
+    res.m_indptr = Matrix(MatrixType::INT64, 1, rows.m_rows.size() + 1);
+
+    MatrixWriter<int64_t> indices(res.m_indices);
+    MatrixWriter<int64_t> indptr(res.m_indptr);
+    visit_matrix_writer<T>(res.m_data, scorer_flags, [&](auto& data) {
+        size_t pos = 0;
+        indptr.set(0, 0, int64_t(0));
+        for (size_t row = 0; row < rows.m_rows.size(); ++row) {
+            for (const auto& elem : rows.m_rows[row]) {
+                data.set(0, pos, elem.second);
+                indices.set(0, pos, static_cast<int64_t>(elem.first));
+                pos++;
+            }
+            indptr.set(0, row + 1, static_cast<int64_t>(pos));
+
+            /* free the buffers while copying, so the peak memory usage stays low */
+            std::vector<std::pair<size_t, T>>().swap(rows.m_rows[row]);
+        }
+    });
+
+    return res;
+}
+
+/**
+ * @brief result of cdist_topk. Row i holds the indices and scores of the best `limit` choices
+ * for query i sorted like the results of extract. Rows with less matches are padded with the
+ * index -1 and the worst score saturated to the range of the dtype.
+ */
+struct TopKMatrix {
+    Matrix m_indices;
+    Matrix m_scores;
+};
+
+/**
+ * @brief best `limit` choices for each query. Every query keeps its matches in an ExtractTopK,
+ * so the score_cutoff passed to the scorer is tightened once it is filled. A block of queries
+ * sharing a multi string scorer uses the loosest score_cutoff of the block.
+ */
+template <typename T>
+static TopKMatrix cdist_topk_impl(const RF_ScorerFlags* scorer_flags, const RF_Kwargs* kwargs,
+                                  RF_Scorer* scorer, const std::vector<RF_StringWrapper>& queries,
+                                  const std::vector<RF_StringWrapper>& choices, int64_t limit,
+                                  MatrixType dtype, int workers, T score_cutoff, T score_hint,
+                                  T worst_score)
+{
+    if (limit <= 0) throw std::invalid_argument("limit has to be > 0");
+
+    int64_t cols = choices.size();
+    size_t k = static_cast<size_t>(limit);
+    bool lowest_score_worst = is_lowest_score_worst<T>(scorer_flags);
+    TopKMatrix res;
+    res.m_indices = Matrix(MatrixType::INT64, queries.size(), k);
+    res.m_scores = Matrix(dtype, queries.size(), k);
+    MatrixWriter<int64_t> indices(res.m_indices);
+    /* converted to dtype once all rows are done */
+    std::vector<T> scores(queries.size() * k);
+    const T pad_score = saturate_score(worst_score, dtype);
+
+    auto store_row = [&](size_t row, ExtractTopK<T>& heap) {
+        std::vector<IndexMatchElem<T>> matches = heap.take_sorted();
+        for (size_t i = 0; i < k; ++i) {
+            if (i < matches.size()) {
+                indices.set(row, i, matches[i].index);
+                scores[row * k + i] = matches[i].score;
             }
+            else {
+                indices.set(row, i, int64_t(-1));
+                scores[row * k + i] = pad_score;
+            }
+        }
+    };
+
+    bool multiStringLong = scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_LONG;
+    MultiStringBlocks blocks;
+    if (scorer_flags->flags & RF_SCORER_FLAG_MULTI_STRING_INIT) {
+        blocks = multi_string_blocks(queries, multiStringLong);
+    }
+    else {
+        for (size_t i = 0; i < queries.size(); ++i)
+            if (!queries[i].is_none()) blocks.indices.push_back(i);
+
+        /* longest queries first, since they take the longest to process */
+        std::stable_sort(blocks.indices.begin(), blocks.indices.end(), [&](size_t i1, size_t i2) {
+            return queries[i1].size() > queries[i2].size();
         });
+        blocks.long_count = blocks.indices.size();
     }
 
-    return matrix;
+    for (size_t row = 0; row < queries.size(); ++row) {
+        if (!queries[row].is_none()) continue;
+
+        ExtractTopK<T> heap(scorer_flags, limit, score_cutoff);
+        store_row(row, heap);
+    }
+
+    auto score_row = [&](size_t row) {
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, 1, &queries[row].string);
+        ExtractTopK<T> heap(scorer_flags, limit, score_cutoff);
+
+        for (int64_t col = 0; col < cols; ++col) {
+            if (choices[col].is_none()) continue;
+
+            T score;
+            ScorerFunc.call(&choices[col].string, heap.score_cutoff(), score_hint, &score);
+            heap.push(score, col);
+        }
+
+        store_row(row, heap);
+    };
+
+    auto score_block = [&](size_t begin, size_t end) {
+        int64_t row_count = static_cast<int64_t>(end - begin);
+        assert(row_count <= 256 / 8);
+        T scores[256 / 8];
+        RF_String strings[256 / 8];
+
+        for (int64_t i = 0; i < row_count; ++i)
+            strings[i] = queries[blocks.indices[begin + i]].string;
+
+        RF_ScorerWrapper ScorerFunc = init_scorer_func(scorer, kwargs, row_count, strings);
+        std::vector<ExtractTopK<T>> heaps(static_cast<size_t>(row_count),
+                                          ExtractTopK<T>(scorer_flags, limit, score_cutoff));
+
+        for (int64_t col = 0; col < cols; ++col) {
+            if (choices[col].is_none()) continue;
+
+            T block_cutoff = heaps[0].score_cutoff();
+            for (const auto& heap : heaps)
+                block_cutoff = lowest_score_worst ? std::min(block_cutoff, heap.score_cutoff())
+                                                  : std::max(block_cutoff, heap.score_cutoff());
+
+            ScorerFunc.call(&choices[col].string, block_cutoff, score_hint, scores);
+            for (int64_t i = 0; i < row_count; ++i)
+                heaps[static_cast<size_t>(i)].push(scores[i], col);
+        }
+
+        for (int64_t i = 0; i < row_count; ++i)
+            store_row(blocks.indices[begin + i], heaps[static_cast<size_t>(i)]);
+    };
+
+    const int64_t choices_cost = strings_cost(choices);
+    std::vector<int64_t> unit_costs;
+    unit_costs.reserve(blocks.long_count + blocks.blocks.size());
+    for (size_t i = 0; i < blocks.long_count; ++i)
+        unit_costs.push_back(scalar_cost_factor(queries[blocks.indices[i]].size()) * choices_cost);
+    for (const auto& block : blocks.blocks) {
+        size_t width = multi_string_width(queries[blocks.indices[block.first]].size(), multiStringLong);
+        unit_costs.push_back(block_cost_factor(width) * choices_cost);
+    }
+
+    run_parallel_balanced(workers, unit_costs, [&](int64_t task, int64_t task_end) {
+        for (; task < task_end; ++task) {
+            size_t unit = static_cast<size_t>(task);
+            if (unit < blocks.long_count) {
+                score_row(blocks.indices[unit]);
+            }
+            else {
+                const auto& block = blocks.blocks[unit - blocks.long_count];
+                score_block(block.first, block.second);
+            }
+        }
+    });
+
+    visit_matrix_writer<T>(res.m_scores, scorer_flags, [&](auto& writer) {
+        for (size_t row = 0; row < queries.size(); ++row)
+            for (size_t i = 0; i < k; ++i)
+                writer.set(row, i, scores[row * k + i]);
+    });
+
+    return res;
 }
@@ -5,21 +5,30 @@ from __future__ import annotations
 
 from typing import TYPE_CHECKING, Any, Callable, Collection, Hashable, Sequence
 
+from rapidfuzz._utils import vectorized_import
 from rapidfuzz.fuzz import ratio
-from rapidfuzz.process_cpp_impl import FLOAT32 as _FLOAT32
-from rapidfuzz.process_cpp_impl import FLOAT64 as _FLOAT64
-from rapidfuzz.process_cpp_impl import INT8 as _INT8
-from rapidfuzz.process_cpp_impl import INT16 as _INT16
-from rapidfuzz.process_cpp_impl import INT32 as _INT32
-from rapidfuzz.process_cpp_impl import INT64 as _INT64
-from rapidfuzz.process_cpp_impl import UINT8 as _UINT8
-from rapidfuzz.process_cpp_impl import UINT16 as _UINT16
-from rapidfuzz.process_cpp_impl import UINT32 as _UINT32
-from rapidfuzz.process_cpp_impl import UINT64 as _UINT64
-from rapidfuzz.process_cpp_impl import cdist as _cdist
-from rapidfuzz.process_cpp_impl import extract, extract_iter, extractOne
-
-__all__ = ["extract", "extract_iter", "extractOne", "cdist"]
+
+_process_cpp_impl = vectorized_import("rapidfuzz.process_cpp_impl")
+
+_FLOAT32 = _process_cpp_impl.FLOAT32
+_FLOAT64 = _process_cpp_impl.FLOAT64
+_INT8 = _process_cpp_impl.INT8
+_INT16 = _process_cpp_impl.INT16
+_INT32 = _process_cpp_impl.INT32
+_INT64 = _process_cpp_impl.INT64
+_UINT8 = _process_cpp_impl.UINT8
+_UINT16 = _process_cpp_impl.UINT16
+_UINT32 = _process_cpp_impl.UINT32
+_UINT64 = _process_cpp_impl.UINT64
+_cdist = _process_cpp_impl.cdist
+_cdist_sparse = _process_cpp_impl.cdist_sparse
+_cdist_topk = _process_cpp_impl.cdist_topk
+Corpus = _process_cpp_impl.Corpus
+extract = _process_cpp_impl.extract
+extract_iter = _process_cpp_impl.extract_iter
+extractOne = _process_cpp_impl.extractOne
+
+__all__ = ["extract", "extract_iter", "extractOne", "cdist", "cdist_sparse", "cdist_topk", "Corpus"]
 
 if TYPE_CHECKING:
     import numpy as np
@@ -55,9 +64,23 @@ def _dtype_to_type_num(dtype: np.dtype | None) -> int | None:
     raise TypeError(msg)
 
 
+def _out_dtype(out: np.ndarray, dtype: np.dtype | None) -> np.dtype:
+    import numpy as np
+
+    if dtype is not None and np.dtype(dtype) != out.dtype:
+        msg = "the dtype of out does not match dtype"
+        raise ValueError(msg)
+    if not out.dtype.isnative:
+        msg = "out has to use the native byte order"
+        raise ValueError(msg)
+
+    # e.g. np.intc and np.int_ are separate types of the same size
+    return np.dtype(f"{out.dtype.kind}{out.dtype.itemsize}").type
+
+
 def cdist(
-    queries: Collection[Sequence[Hashable] | None],
-    choices: Collection[Sequence[Hashable] | None],
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
     *,
     scorer: Callable[..., int | float] = ratio,
     processor: Callable[..., Sequence[Hashable]] | None = None,
@@ -65,10 +88,14 @@ def cdist(
     score_hint: int | float | None = None,
     dtype: np.dtype | None = None,
     workers: int = 1,
+    out: np.ndarray | None = None,
     **kwargs: Any,
 ) -> np.ndarray:
     import numpy as np
 
+    if out is not None:
+        dtype = _out_dtype(out, dtype)
+
     dtype = _dtype_to_type_num(dtype)
     return np.asarray(
         _cdist(
@@ -80,6 +107,67 @@ def cdist(
             score_hint=score_hint,
             dtype=dtype,
             workers=workers,
+            out=out,
             **kwargs,
         )
     )
+
+
+def cdist_sparse(
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
+    *,
+    scorer: Callable[..., int | float] = ratio,
+    processor: Callable[..., Sequence[Hashable]] | None = None,
+    score_cutoff: int | float | None = None,
+    score_hint: int | float | None = None,
+    dtype: np.dtype | None = None,
+    workers: int = 1,
+    **kwargs: Any,
+) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
+    import numpy as np
+
+    dtype = _dtype_to_type_num(dtype)
+    data, indices, indptr = _cdist_sparse(
+        queries,
+        choices,
+        scorer=scorer,
+        processor=processor,
+        score_cutoff=score_cutoff,
+        score_hint=score_hint,
+        dtype=dtype,
+        workers=workers,
+        **kwargs,
+    )
+    return (np.asarray(data)[0], np.asarray(indices)[0], np.asarray(indptr)[0])
+
+
+def cdist_topk(
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
+    *,
+    limit: int = 5,
+    scorer: Callable[..., int | float] = ratio,
+    processor: Callable[..., Sequence[Hashable]] | None = None,
+    score_cutoff: int | float | None = None,
+    score_hint: int | float | None = None,
+    dtype: np.dtype | None = None,
+    workers: int = 1,
+    **kwargs: Any,
+) -> tuple[np.ndarray, np.ndarray]:
+    import numpy as np
+
+    dtype = _dtype_to_type_num(dtype)
+    indices, scores = _cdist_topk(
+        queries,
+        choices,
+        limit=limit,
+        scorer=scorer,
+        processor=processor,
+        score_cutoff=score_cutoff,
+        score_hint=score_hint,
+        dtype=dtype,
+        workers=workers,
+        **kwargs,
+    )
+    return (np.asarray(indices), np.asarray(scores))
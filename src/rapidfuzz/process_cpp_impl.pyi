@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+from os import PathLike
 from typing import (
     Any,
     Callable,
@@ -22,6 +23,33 @@ _S1 = TypeVar("_S1")
 _S2 = TypeVar("_S2")
 _ResultType = Union[int, float]
 
+class Corpus:
+    choices: list[Any]
+    keys: list[Any] | None
+    processor: Callable[..., _StringType] | None
+    qgram_size: int | None
+    def __init__(
+        self,
+        choices: Iterable[_StringType | None] | Mapping[Any, _StringType | None],
+        *,
+        processor: Callable[..., _StringType] | None = None,
+        qgram_size: int | None = None,
+        workers: int = 1,
+    ) -> None: ...
+    def __len__(self) -> int: ...
+    def build_bktree(
+        self, scorer: Callable[..., int], *, scorer_kwargs: dict[str, Any] | None = None
+    ) -> None: ...
+    def save(self, path: str | PathLike[str]) -> None: ...
+    @classmethod
+    def load(
+        cls,
+        path: str | PathLike[str],
+        *,
+        processor: Callable[..., _StringType] | None = None,
+        qgram_size: int | None = None,
+    ) -> Corpus: ...
+
 @overload
 def extractOne(
     query: _S1,
@@ -31,6 +59,7 @@ def extractOne(
     processor: Callable[..., _StringType] | None = None,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[_S2, _ResultType, int]: ...
 @overload
@@ -42,9 +71,22 @@ def extractOne(
     processor: Callable[..., _StringType] | None = None,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[_S2, _ResultType, Any]: ...
 @overload
+def extractOne(
+    query: _S1,
+    choices: Corpus,
+    *,
+    scorer: Callable[..., _ResultType] = WRatio,
+    processor: Callable[..., _StringType] | None = None,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[Any, _ResultType, Any]: ...
+@overload
 def extract(
     query: _S1,
     choices: Collection[_S2],
@@ -54,6 +96,7 @@ def extract(
     limit: int | None = 5,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[_S2, _ResultType, int]]: ...
 @overload
@@ -66,9 +109,23 @@ def extract(
     limit: int | None = 5,
     score_cutoff: _ResultType | None = None,
     score_hint: _ResultType | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[_S2, _ResultType, Any]]: ...
 @overload
+def extract(
+    query: _S1,
+    choices: Corpus,
+    *,
+    scorer: Callable[..., _ResultType] = WRatio,
+    processor: Callable[..., _StringType] | None = None,
+    limit: int | None = 5,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> list[tuple[Any, _ResultType, Any]]: ...
+@overload
 def extract_iter(
     query: _S1,
     choices: Iterable[_S2],
@@ -103,8 +160,8 @@ UINT32: int
 UINT64: int
 
 def cdist(
-    queries: Iterable[_S1],
-    choices: Iterable[_S2],
+    queries: Iterable[_S1] | Corpus,
+    choices: Iterable[_S2] | Corpus,
     *,
     scorer: Callable[..., _ResultType] = ratio,
     processor: Callable[..., _StringType] | None = None,
@@ -113,4 +170,30 @@ def cdist(
     dtype: int | None = None,
     workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
+    out: Any | None = None,
 ) -> Any: ...
+def cdist_sparse(
+    queries: Iterable[_S1] | Corpus,
+    choices: Iterable[_S2] | Corpus,
+    *,
+    scorer: Callable[..., _ResultType] = ratio,
+    processor: Callable[..., _StringType] | None = None,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    dtype: int | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[Any, Any, Any]: ...
+def cdist_topk(
+    queries: Iterable[_S1] | Corpus,
+    choices: Iterable[_S2] | Corpus,
+    *,
+    limit: int = 5,
+    scorer: Callable[..., _ResultType] = ratio,
+    processor: Callable[..., _StringType] | None = None,
+    score_cutoff: _ResultType | None = None,
+    score_hint: _ResultType | None = None,
+    dtype: int | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[Any, Any]: ...
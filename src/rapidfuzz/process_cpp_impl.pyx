@@ -1,19 +1,33 @@
 # distutils: language=c++
 # cython: language_level=3, binding=True, linetrace=True
 
+from rapidfuzz._utils import processor_name
 from rapidfuzz.fuzz import WRatio, ratio
+from rapidfuzz.utils import default_process
 
 cimport cython
+from cython.operator cimport dereference
 from cpp_common cimport (
     PyObjectWrapper,
     RF_KwargsWrapper,
     RF_StringWrapper,
+    StringArena,
     conv_sequence,
+    convert_string,
     get_score_cutoff_f64,
     get_score_cutoff_i64,
+    validate_string,
 )
 from cpython cimport Py_buffer
-from cpython.buffer cimport PyBUF_F_CONTIGUOUS, PyBUF_ND, PyBUF_SIMPLE
+from cpython.buffer cimport (
+    PyBUF_F_CONTIGUOUS,
+    PyBUF_ND,
+    PyBUF_RECORDS_RO,
+    PyBUF_SIMPLE,
+    PyBUF_WRITABLE,
+    PyBuffer_Release,
+    PyObject_GetBuffer,
+)
 from cpython.exc cimport PyErr_CheckSignals
 from cpython.list cimport PyList_New, PyList_SET_ITEM
 from cpython.object cimport PyObject
@@ -21,15 +35,20 @@ from cpython.ref cimport Py_INCREF
 from libcpp.cmath cimport floor, isnan
 from libc.stdint cimport int32_t, int64_t, uint8_t, uint64_t
 from libcpp cimport algorithm, bool
+from libcpp.string cimport string
 from libcpp.utility cimport move
 from libcpp.vector cimport vector
 
+import atexit
 import heapq
 from array import array
+from itertools import islice
 
 from cpython.pycapsule cimport PyCapsule_GetPointer, PyCapsule_IsValid
 
 from rapidfuzz cimport (
+    RF_SCORER_FLAG_LCS_BOUND,
+    RF_SCORER_FLAG_LENGTH_BOUND,
     RF_SCORER_FLAG_RESULT_F64,
     RF_SCORER_FLAG_RESULT_I64,
     RF_SCORER_FLAG_SYMMETRIC,
@@ -45,7 +64,31 @@ from rapidfuzz cimport (
 )
 
 
+cdef extern from "bk_tree.hpp":
+    cdef cppclass BKTree:
+        BKTree()
+        void clear()
+        bool empty()
+
+cdef extern from "qgram_index.hpp":
+    cdef cppclass QGramIndex:
+        QGramIndex()
+        void build(const vector[RF_StringWrapper]&, size_t) except + nogil
+        size_t qgram_size()
+
 cdef extern from "process_cpp.hpp":
+    cdef cppclass CharSignatures:
+        CharSignatures()
+        void build(const vector[RF_StringWrapper]&) except +
+        bool built()
+
+    cdef cppclass LengthBuckets:
+        LengthBuckets()
+        void build(const vector[RF_StringWrapper]&) except + nogil
+        bool built()
+
+    void thread_pool_shutdown "ThreadPool::shutdown"() nogil
+
     cdef cppclass ExtractComp:
         ExtractComp()
         ExtractComp(const RF_ScorerFlags* scorer_flags)
@@ -78,6 +121,10 @@ cdef extern from "process_cpp.hpp":
         PyObjectWrapper val
         RF_StringWrapper proc_val
 
+    cdef cppclass IndexMatchElem[T]:
+        T score
+        int64_t index
+
     cdef cppclass RF_ScorerWrapper:
         RF_ScorerFunc scorer_func
 
@@ -89,11 +136,23 @@ cdef extern from "process_cpp.hpp":
 
     cdef vector[DictMatchElem[T]] extract_dict_impl[T](
         const RF_Kwargs*, const RF_ScorerFlags*, RF_Scorer*,
-        const RF_StringWrapper&, const vector[DictStringElem]&, T, T) except +
+        const RF_StringWrapper&, const vector[DictStringElem]&, T, T, int64_t, int) except +
 
     cdef vector[ListMatchElem[T]] extract_list_impl[T](
         const RF_Kwargs*, const RF_ScorerFlags*, RF_Scorer*,
-        const RF_StringWrapper&, const vector[ListStringElem]&, T, T) except +
+        const RF_StringWrapper&, const vector[ListStringElem]&, T, T, int64_t, int) except +
+
+    cdef vector[IndexMatchElem[T]] extract_corpus_impl[T](
+        const RF_Kwargs*, const RF_ScorerFlags*, RF_Scorer*,
+        const RF_StringWrapper&, const vector[RF_StringWrapper]&, const QGramIndex&, const BKTree*,
+        const CharSignatures*, const LengthBuckets*, T, T, int64_t, int) except +
+
+    void build_bk_tree(BKTree&, const RF_ScorerFlags*, const RF_Kwargs*, RF_Scorer*,
+        const vector[RF_StringWrapper]&) except +
+
+    void default_process_batch(vector[RF_StringWrapper]&, StringArena&, int) except +
+    void default_process_batch(vector[ListStringElem]&, StringArena&, int) except +
+    void default_process_batch(vector[DictStringElem]&, StringArena&, int) except +
 
     cdef bool is_lowest_score_worst[T](const RF_ScorerFlags* scorer_flags)
     cdef T get_optimal_score[T](const RF_ScorerFlags* scorer_flags)
@@ -114,6 +173,7 @@ cdef extern from "process_cpp.hpp":
     cdef cppclass RfMatrix "Matrix":
         RfMatrix() except +
         RfMatrix(MatrixType, size_t, size_t) except +
+        RfMatrix(MatrixType, size_t, size_t, void*, int64_t, int64_t) except +
         int get_dtype_size() except +
         const char* get_format() except +
         void set[T](size_t, size_t, T) except +
@@ -122,12 +182,57 @@ cdef extern from "process_cpp.hpp":
         size_t m_rows
         size_t m_cols
         void* m_matrix
+        int64_t m_row_stride
+        int64_t m_col_stride
 
-    RfMatrix cdist_single_list_impl[T](  const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
-        const vector[RF_StringWrapper]&, MatrixType, int, T, T, T) except +
-    RfMatrix cdist_two_lists_impl[T](    const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
+    cdef T saturate_score[T](T score, MatrixType dtype)
+
+    void cdist_single_list_impl[T](  const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
+        const vector[RF_StringWrapper]&, RfMatrix&, int, T, T, T) except +
+    void cdist_two_lists_impl[T](    const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
+        const vector[RF_StringWrapper]&, const vector[RF_StringWrapper]&, RfMatrix&, int, T, T, T) except +
+
+    cdef cppclass RfSparseMatrix "SparseMatrix":
+        RfMatrix m_data
+        RfMatrix m_indices
+        RfMatrix m_indptr
+
+    RfSparseMatrix cdist_sparse_impl[T](    const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
         const vector[RF_StringWrapper]&, const vector[RF_StringWrapper]&, MatrixType, int, T, T, T) except +
 
+    cdef cppclass RfTopKMatrix "TopKMatrix":
+        RfMatrix m_indices
+        RfMatrix m_scores
+
+    RfTopKMatrix cdist_topk_impl[T](    const RF_ScorerFlags* scorer_flags, const RF_Kwargs*, RF_Scorer*,
+        const vector[RF_StringWrapper]&, const vector[RF_StringWrapper]&, int64_t, MatrixType, int, T, T, T) except +
+
+cdef extern from "corpus_file.hpp":
+    cdef cppclass CorpusFileWriter:
+        void add_table(const vector[RF_StringWrapper]&) except +
+        void set_processor(const string&) except +
+        size_t size()
+        void write(char*) except + nogil
+
+    cdef cppclass CorpusFileView:
+        CorpusFileView()
+        CorpusFileView(const char*, size_t) except +
+        size_t size()
+        size_t table_count()
+        const string& processor()
+        RF_String get(size_t, size_t) except +
+        vector[RF_StringWrapper] strings(size_t) except +
+
+cdef extern from "Python.h":
+    object PyUnicode_FromKindAndData(int kind, const void* buffer, Py_ssize_t size)
+
+cdef inline bool is_supported_scorer(const RF_Scorer* scorer_context):
+    # version 2 scorers only lack RF_ScorerFunc.call_batch, which is optional
+    if scorer_context == NULL:
+        return False
+
+    return scorer_context.version == 2 or scorer_context.version == SCORER_STRUCT_VERSION
+
 cdef inline bool is_none(s):
     if s is None:
         return True
@@ -137,7 +242,7 @@ cdef inline bool is_none(s):
 
     return False
 
-cdef inline vector[DictStringElem] preprocess_dict(queries, processor) except *:
+cdef inline vector[DictStringElem] preprocess_dict(queries, processor, StringArena* arena, int workers) except *:
     cdef vector[DictStringElem] proc_queries
     cdef int64_t queries_len = <int64_t>len(queries)
     cdef RF_String proc_str
@@ -154,8 +259,21 @@ cdef inline vector[DictStringElem] preprocess_dict(queries, processor) except *:
                 i,
                 move(PyObjectWrapper(query_key)),
                 move(PyObjectWrapper(query)),
-                move(RF_StringWrapper(conv_sequence(query)))
+                move(RF_StringWrapper(conv_sequence(query, arena)))
+            )
+    # default_process is applied by the workers while copying the strings into the arena
+    elif processor is default_process:
+        for i, (query_key, query) in enumerate(queries.items()):
+            if is_none(query):
+                continue
+            validate_string(query, "sentence must be a String")
+            proc_queries.emplace_back(
+                i,
+                move(PyObjectWrapper(query_key)),
+                move(PyObjectWrapper(query)),
+                move(RF_StringWrapper(convert_string(query)))
             )
+        default_process_batch(proc_queries, arena[0], workers)
     else:
         processor_capsule = getattr(processor, '_RF_Preprocess', processor)
         if PyCapsule_IsValid(processor_capsule, NULL):
@@ -184,12 +302,12 @@ cdef inline vector[DictStringElem] preprocess_dict(queries, processor) except *:
                     i,
                     move(PyObjectWrapper(query_key)),
                     move(PyObjectWrapper(query)),
-                    move(RF_StringWrapper(conv_sequence(proc_query), proc_query))
+                    move(RF_StringWrapper(conv_sequence(proc_query, arena), proc_query))
                 )
 
     return move(proc_queries)
 
-cdef inline vector[ListStringElem] preprocess_list(queries, processor) except *:
+cdef inline vector[ListStringElem] preprocess_list(queries, processor, StringArena* arena, int workers) except *:
     cdef vector[ListStringElem] proc_queries
     cdef int64_t queries_len = <int64_t>len(queries)
     cdef RF_String proc_str
@@ -205,8 +323,20 @@ cdef inline vector[ListStringElem] preprocess_list(queries, processor) except *:
             proc_queries.emplace_back(
                 i,
                 move(PyObjectWrapper(query)),
-                move(RF_StringWrapper(conv_sequence(query)))
+                move(RF_StringWrapper(conv_sequence(query, arena)))
             )
+    # default_process is applied by the workers while copying the strings into the arena
+    elif processor is default_process:
+        for i, query in enumerate(queries):
+            if is_none(query):
+                continue
+            validate_string(query, "sentence must be a String")
+            proc_queries.emplace_back(
+                i,
+                move(PyObjectWrapper(query)),
+                move(RF_StringWrapper(convert_string(query)))
+            )
+        default_process_batch(proc_queries, arena[0], workers)
     else:
         processor_capsule = getattr(processor, '_RF_Preprocess', processor)
         if PyCapsule_IsValid(processor_capsule, NULL):
@@ -233,11 +363,344 @@ cdef inline vector[ListStringElem] preprocess_list(queries, processor) except *:
                 proc_queries.emplace_back(
                     i,
                     move(PyObjectWrapper(query)),
-                    move(RF_StringWrapper(conv_sequence(proc_query), proc_query))
+                    move(RF_StringWrapper(conv_sequence(proc_query, arena), proc_query))
                 )
 
     return move(proc_queries)
 
+cdef inline vector[RF_StringWrapper] preprocess(queries, processor, bool none_as_empty, StringArena* arena,
+                                                int workers) except *:
+    cdef vector[RF_StringWrapper] proc_queries
+    cdef int64_t queries_len = <int64_t>len(queries)
+    cdef RF_String proc_str
+    cdef RF_Preprocessor* processor_context = NULL
+    proc_queries.reserve(queries_len)
+
+    # No processor
+    if not processor:
+        for query in queries:
+            if none_as_empty and is_none(query):
+                proc_queries.emplace_back()
+            else:
+                proc_queries.emplace_back(conv_sequence(query, arena), <PyObject*>query)
+    # default_process is applied by the workers while copying the strings into the arena.
+    # The strings are referenced until then, since they are read without holding the GIL
+    elif processor is default_process:
+        for query in queries:
+            if none_as_empty and is_none(query):
+                proc_queries.emplace_back()
+            else:
+                validate_string(query, "sentence must be a String")
+                proc_queries.emplace_back(convert_string(query), <PyObject*>query)
+        default_process_batch(proc_queries, arena[0], workers)
+    else:
+        processor_capsule = getattr(processor, '_RF_Preprocess', processor)
+        if PyCapsule_IsValid(processor_capsule, NULL):
+            processor_context = <RF_Preprocessor*>PyCapsule_GetPointer(processor_capsule, NULL)
+
+        # use RapidFuzz C-Api
+        if processor_context != NULL and processor_context.version == SCORER_STRUCT_VERSION:
+            for query in queries:
+                if none_as_empty and is_none(query):
+                    proc_queries.emplace_back()
+                else:
+                    processor_context.preprocess(query, &proc_str)
+                    proc_queries.emplace_back(proc_str, <PyObject*>query)
+
+        # Call Processor through Python
+        else:
+            for query in queries:
+                if none_as_empty and is_none(query):
+                    proc_queries.emplace_back()
+                else:
+                    proc_query = processor(query)
+                    proc_queries.emplace_back(conv_sequence(proc_query, arena), <PyObject*>proc_query)
+
+    return move(proc_queries)
+
+
+cdef class Corpus:
+    """
+    Collection of choices, which are preprocessed once and can then be passed as
+    `choices` to extract, extractOne and cdist multiple times.
+    The processor passed to these functions is only applied to the query.
+    """
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] proc_choices
+    cdef list _choices
+    cdef readonly list keys
+    cdef readonly object processor
+    cdef bool contains_none
+    # the processed choices differ from the choices
+    cdef bool processed
+    # memory mapped corpus file the strings of a loaded corpus point into
+    cdef object mapping
+    cdef Py_buffer mapping_view
+    cdef bool has_mapping_view
+    cdef CorpusFileView file
+    cdef QGramIndex qgram_index
+    # BK-tree and the scorer it was built with
+    cdef BKTree bk_tree
+    cdef const RF_Scorer* bk_tree_scorer
+    cdef dict bk_tree_scorer_kwargs
+    # character signatures of the processed choices
+    cdef CharSignatures char_signatures
+    # processed choices grouped by their length
+    cdef LengthBuckets length_buckets
+
+    def __init__(self, choices, *, processor=None, qgram_size=None, workers=1):
+        if hasattr(choices, "items"):
+            self.keys = list(choices.keys())
+            self._choices = list(choices.values())
+        else:
+            self.keys = None
+            self._choices = list(choices)
+
+        self.processor = processor
+        self.processed = processor is not None
+        self.contains_none = False
+        for choice in self._choices:
+            if is_none(choice):
+                self.contains_none = True
+                break
+
+        self.proc_choices = move(preprocess(self._choices, processor, True, &self.arena, workers))
+        self.build_qgram_index(qgram_size)
+
+    cdef build_qgram_index(self, qgram_size):
+        cdef size_t c_qgram_size
+        if qgram_size is None:
+            return
+
+        if qgram_size < 1:
+            raise ValueError("qgram_size has to be at least 1")
+
+        c_qgram_size = qgram_size
+        with nogil:
+            self.qgram_index.build(self.proc_choices, c_qgram_size)
+
+    @property
+    def qgram_size(self):
+        if self.qgram_index.qgram_size() == 0:
+            return None
+        return self.qgram_index.qgram_size()
+
+    def build_bktree(self, scorer, *, scorer_kwargs=None):
+        """
+        Builds a BK-tree over the processed choices, which is searched by extract and
+        extractOne when they are called with the same scorer and scorer_kwargs.
+        Only the parts of the tree, which can contain choices within the score_cutoff
+        or better than the current `limit` best matches, are compared with the query.
+
+        Parameters
+        ----------
+        scorer : Callable
+            distance adhering to the triangle inequality, like `Levenshtein.distance`
+            or `Indel.distance`.
+        scorer_kwargs : dict[str, Any], optional
+            any other named parameters are passed to the scorer.
+
+        Raises
+        ------
+        ValueError
+            If the scorer does not implement the RapidFuzz C-API or does not adhere
+            to the triangle inequality.
+        """
+        cdef RF_Scorer* scorer_context = NULL
+        cdef RF_ScorerFlags scorer_flags
+        cdef RF_KwargsWrapper kwargs_context
+
+        scorer_kwargs = scorer_kwargs.copy() if scorer_kwargs else {}
+        self.bk_tree.clear()
+        self.bk_tree_scorer = NULL
+
+        scorer_capsule = getattr(scorer, '_RF_Scorer', scorer)
+        if PyCapsule_IsValid(scorer_capsule, NULL):
+            scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
+
+        # the tree is built and searched with the GIL released, so the scorer is only called through the C-API
+        if not is_supported_scorer(scorer_context):
+            raise ValueError("BK-tree requires a scorer implementing the RapidFuzz C-API")
+
+        kwargs_context = RF_KwargsWrapper()
+        scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
+        scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
+        build_bk_tree(self.bk_tree, &scorer_flags, &kwargs_context.kwargs, scorer_context, self.proc_choices)
+
+        self.bk_tree_scorer = scorer_context
+        self.bk_tree_scorer_kwargs = scorer_kwargs
+
+    cdef const BKTree* get_bk_tree(self, const RF_Scorer* scorer, dict scorer_kwargs):
+        """BK-tree, when it was built with the same scorer and scorer_kwargs"""
+        if self.bk_tree.empty() or scorer != self.bk_tree_scorer or scorer_kwargs != self.bk_tree_scorer_kwargs:
+            return NULL
+        return &self.bk_tree
+
+    cdef const CharSignatures* get_char_signatures(self, const RF_ScorerFlags* scorer_flags) except *:
+        """character signatures for scorers, which can use them. They are computed on first use"""
+        if not scorer_flags.flags & RF_SCORER_FLAG_LCS_BOUND:
+            return NULL
+
+        if not self.char_signatures.built():
+            self.char_signatures.build(self.proc_choices)
+        return &self.char_signatures
+
+    cdef const LengthBuckets* get_length_buckets(self, const RF_ScorerFlags* scorer_flags) except *:
+        """choices grouped by their length for scorers, which can use them. They are grouped on first use"""
+        if not scorer_flags.flags & RF_SCORER_FLAG_LENGTH_BOUND:
+            return NULL
+
+        if not self.length_buckets.built():
+            with nogil:
+                self.length_buckets.build(self.proc_choices)
+        return &self.length_buckets
+
+    def __dealloc__(self):
+        # the strings point into the mapping, so it is only closed when the corpus is destroyed
+        if self.has_mapping_view:
+            PyBuffer_Release(&self.mapping_view)
+
+    def __len__(self):
+        return self.proc_choices.size()
+
+    def __repr__(self):
+        return f"Corpus(len={len(self)}, processor={self.processor!r})"
+
+    @property
+    def choices(self):
+        # a loaded corpus only creates the Python strings when they are requested
+        if self._choices is None:
+            self._choices = [self.get_choice(i) for i in range(self.proc_choices.size())]
+        return self._choices
+
+    cdef object get_choice(self, size_t index):
+        """choice `index` without creating the list of all choices"""
+        if self._choices is not None:
+            return self._choices[index]
+
+        cdef RF_String choice = self.file.get(0, index)
+        if choice.data == NULL:
+            return None
+        return PyUnicode_FromKindAndData(1 << <int>choice.kind, choice.data, <Py_ssize_t>choice.length)
+
+    cdef object as_choices(self):
+        """choices in the format they were passed to the Corpus"""
+        if self.keys is None:
+            return self.choices
+        return dict(zip(self.keys, self.choices))
+
+    cdef const vector[RF_StringWrapper]* get_proc_choices(self, const RF_ScorerFlags* scorer_flags) except NULL:
+        if self.contains_none and not scorer_flags.flags & RF_SCORER_NONE_IS_WORST_SCORE:
+            raise TypeError("Corpus contains None, which is not supported by the scorer")
+        return &self.proc_choices
+
+    def save(self, path):
+        """
+        Stores the corpus in a binary file, which can be memory mapped by `Corpus.load`.
+        The file contains the choices, the output of the processor for each of them
+        and the name of the processor.
+
+        Parameters
+        ----------
+        path : str | os.PathLike
+            path of the file
+        """
+        import mmap
+
+        cdef StringArena arena
+        cdef vector[RF_StringWrapper] choices
+        cdef CorpusFileWriter writer
+        cdef Py_buffer view
+
+        if self.keys is not None:
+            raise TypeError("only a Corpus created from a list of choices can be saved")
+
+        if self._choices is None:
+            # the choices of a loaded corpus are already stored in the mapped file
+            choices = move(self.file.strings(0))
+        else:
+            for choice in self._choices:
+                if not is_none(choice) and not isinstance(choice, str):
+                    raise TypeError("only a Corpus of strings can be saved")
+            choices = move(preprocess(self._choices, None, True, &arena, 1))
+
+        writer.add_table(choices)
+        if self.processed:
+            writer.add_table(self.proc_choices)
+            writer.set_processor(processor_name(self.processor).encode())
+
+        with open(path, "wb+") as f:
+            f.truncate(writer.size())
+            with mmap.mmap(f.fileno(), writer.size()) as mapping:
+                PyObject_GetBuffer(mapping, &view, PyBUF_WRITABLE)
+                try:
+                    with nogil:
+                        writer.write(<char*>view.buf)
+                finally:
+                    PyBuffer_Release(&view)
+                mapping.flush()
+
+    @classmethod
+    def load(cls, path, *, processor=None, qgram_size=None):
+        """
+        Memory maps a corpus file written by `Corpus.save`. The strings are used
+        directly from the mapping, so they are not copied and the memory is shared
+        by all processes loading the same file.
+
+        Parameters
+        ----------
+        path : str | os.PathLike
+            path of the file
+        processor : Callable, optional
+            processor the corpus was saved with. The processed choices are stored in
+            the file, so it is only applied when the choices are passed to a scorer,
+            which does not support the RapidFuzz C-API.
+        qgram_size : int, optional
+            length of the q-grams of an inverted index built over the processed choices.
+            See `Corpus`. Default is None, which does not build an index.
+
+        Returns
+        -------
+        Corpus
+
+        Raises
+        ------
+        ValueError
+            If the file is no valid corpus file or `processor` does not match the
+            processor the corpus was saved with.
+        """
+        import mmap
+
+        cdef Corpus corpus = cls.__new__(cls)
+        with open(path, "rb") as f:
+            corpus.mapping = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        PyObject_GetBuffer(corpus.mapping, &corpus.mapping_view, PyBUF_SIMPLE)
+        corpus.has_mapping_view = True
+        corpus.file = CorpusFileView(<const char*>corpus.mapping_view.buf, <size_t>corpus.mapping_view.len)
+
+        # scorers without support for the C-API apply the processor to the choices, so it has to
+        # match the processed choices stored in the file
+        saved_processor = corpus.file.processor().decode()
+        if processor_name(processor) != saved_processor:
+            if not saved_processor:
+                raise ValueError("the corpus file does not store processed choices")
+            raise ValueError(f"the corpus file was saved with the processor {saved_processor}")
+
+        corpus.keys = None
+        corpus.processor = processor
+        corpus.processed = corpus.file.table_count() > 1
+
+        corpus.proc_choices = move(corpus.file.strings(corpus.file.table_count() - 1))
+        corpus.contains_none = False
+        for i in range(corpus.proc_choices.size()):
+            if corpus.proc_choices[i].string.data == NULL:
+                corpus.contains_none = True
+                break
+
+        corpus.build_qgram_index(qgram_size)
+        return corpus
+
 cdef inline extractOne_dict_f64(
     query, choices, RF_Scorer* scorer, const RF_ScorerFlags* scorer_flags,
     processor,
@@ -607,6 +1070,74 @@ cdef inline py_extractOne_dict(query, choices, scorer, processor, double score_c
     return (result_choice, result_score, result_key) if result_choice is not None else None
 
 
+# number of choices extractOne preprocesses at once, when it is called with a single worker
+cdef int64_t EXTRACT_ONE_CHUNK_SIZE = 1024
+
+
+cdef class ItemsChunk:
+    """part of the items of a mapping, which is preprocessed like a dict"""
+    cdef list _items
+
+    def __init__(self, list items):
+        self._items = items
+
+    def __len__(self):
+        return len(self._items)
+
+    def items(self):
+        return self._items
+
+
+cdef inline extractOne_chunked(
+    query, choices,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    processor,
+    score_cutoff,
+    score_hint,
+    const RF_Kwargs* scorer_kwargs
+):
+    """
+    preprocesses and scores the choices in chunks. Each chunk is scored with the GIL released,
+    while no choice after a perfect match is preprocessed
+    """
+    cdef bool is_dict = hasattr(choices, "items")
+    cdef bool lowest_score_worst
+    cdef int64_t offset = 0
+
+    if scorer_flags.flags & RF_SCORER_FLAG_RESULT_F64:
+        lowest_score_worst = is_lowest_score_worst[double](scorer_flags)
+        optimal_score = get_optimal_score[double](scorer_flags)
+    else:
+        lowest_score_worst = is_lowest_score_worst[int64_t](scorer_flags)
+        optimal_score = get_optimal_score[int64_t](scorer_flags)
+
+    choices_iter = iter(choices.items()) if is_dict else iter(choices)
+    result = None
+    while True:
+        chunk = list(islice(choices_iter, EXTRACT_ONE_CHUNK_SIZE))
+        if not chunk:
+            return result
+
+        if is_dict:
+            matches = extract_dict(query, ItemsChunk(chunk), scorer, scorer_flags,
+                processor, 1, score_cutoff, score_hint, scorer_kwargs, 1)
+        else:
+            matches = extract_list(query, chunk, scorer, scorer_flags,
+                processor, 1, score_cutoff, score_hint, scorer_kwargs, 1)
+
+        # later chunks only replace the match when they improve on it
+        if matches:
+            choice, score, key = matches[0]
+            if result is None or (score > result[1] if lowest_score_worst else score < result[1]):
+                result = (choice, score, key if is_dict else key + offset)
+                score_cutoff = score
+                if score == optimal_score:
+                    return result
+
+        offset += len(chunk)
+
+
 cdef inline py_extractOne_list(query, choices, scorer, processor, double score_cutoff, worst_score, optimal_score, dict scorer_kwargs):
     cdef bool lowest_score_worst = optimal_score > worst_score
     cdef bool result_found = False
@@ -647,9 +1178,10 @@ cdef inline py_extractOne_list(query, choices, scorer, processor, double score_c
     return (result_choice, result_score, result_index) if result_choice is not None else None
 
 
-def extractOne(query, choices, *, scorer=WRatio, processor=None, score_cutoff=None, score_hint=None, scorer_kwargs=None):
+def extractOne(query, choices, *, scorer=WRatio, processor=None, score_cutoff=None, score_hint=None, workers=1, scorer_kwargs=None):
     cdef RF_Scorer* scorer_context = NULL
     cdef RF_ScorerFlags scorer_flags
+    cdef int c_workers = workers
 
     scorer_kwargs = scorer_kwargs.copy() if scorer_kwargs else {}
 
@@ -665,11 +1197,36 @@ def extractOne(query, choices, *, scorer=WRatio, processor=None, score_cutoff=No
     if PyCapsule_IsValid(scorer_capsule, NULL):
         scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
 
-    if scorer_context and scorer_context.version == SCORER_STRUCT_VERSION:
+    if is_supported_scorer(scorer_context):
         kwargs_context = RF_KwargsWrapper()
         scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
         scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
 
+        if isinstance(choices, Corpus):
+            results = extract_corpus(query, choices, scorer_context, &scorer_flags,
+                1, score_cutoff, score_hint, &kwargs_context.kwargs,
+                (<Corpus>choices).get_bk_tree(scorer_context, scorer_kwargs), c_workers)
+            return results[0] if results else None
+
+        # split the preprocessed choices between the workers and only keep the best match of each
+        if c_workers != 0 and c_workers != 1:
+            if hasattr(choices, "items"):
+                results = extract_dict(query, choices, scorer_context, &scorer_flags,
+                    processor, 1, score_cutoff, score_hint, &kwargs_context.kwargs, c_workers)
+            else:
+                if not hasattr(choices, "__len__"):
+                    choices = list(choices)
+                results = extract_list(query, choices, scorer_context, &scorer_flags,
+                    processor, 1, score_cutoff, score_hint, &kwargs_context.kwargs, c_workers)
+
+            return results[0] if results else None
+
+        # choices with a known length are preprocessed in chunks, so they are scored with the GIL released.
+        # Iterators are scored while iterating over them
+        if hasattr(choices, "__len__"):
+            return extractOne_chunked(query, choices, scorer_context, &scorer_flags,
+                processor, score_cutoff, score_hint, &kwargs_context.kwargs)
+
         if hasattr(choices, "items"):
             return extractOne_dict(query, choices, scorer_context, &scorer_flags,
                 processor, score_cutoff, score_hint, &kwargs_context.kwargs)
@@ -678,6 +1235,11 @@ def extractOne(query, choices, *, scorer=WRatio, processor=None, score_cutoff=No
                 processor, score_cutoff, score_hint, &kwargs_context.kwargs)
 
 
+    # the corpus only stores the choices preprocessed for the C-API
+    if isinstance(choices, Corpus):
+        processor = (<Corpus>choices).processor
+        choices = (<Corpus>choices).as_choices()
+
     worst_score, optimal_score = get_scorer_flags_py(scorer, scorer_kwargs)
     # the scorer has to be called through Python
     if score_cutoff is None:
@@ -699,26 +1261,23 @@ cdef inline extract_dict_f64(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
+    cdef StringArena arena
     proc_query = move(RF_StringWrapper(conv_sequence(query)))
-    proc_choices = preprocess_dict(choices, processor)
+    proc_choices = preprocess_dict(choices, processor, &arena, c_workers)
 
     cdef vector[DictMatchElem[double]] results = extract_dict_impl[double](
         scorer_kwargs, scorer_flags, scorer, proc_query, proc_choices,
         get_score_cutoff_f64(score_cutoff, scorer_flags),
-        get_score_cutoff_f64(score_hint, scorer_flags)
+        get_score_cutoff_f64(score_hint, scorer_flags),
+        limit,
+        c_workers
     )
 
     # due to score_cutoff not always completely filled
-    if limit > <int64_t>results.size():
-        limit = <int64_t>results.size()
-
-    if limit >= <int64_t>results.size():
-        algorithm.sort(results.begin(), results.end(), ExtractComp(scorer_flags))
-    else:
-        algorithm.partial_sort(results.begin(), results.begin() + <ptrdiff_t>limit, results.end(), ExtractComp(scorer_flags))
-        results.resize(limit)
+    limit = <int64_t>results.size()
 
     # copy elements into Python List
     result_list = PyList_New(<Py_ssize_t>limit)
@@ -738,26 +1297,23 @@ cdef inline extract_dict_i64(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
+    cdef StringArena arena
     proc_query = move(RF_StringWrapper(conv_sequence(query)))
-    proc_choices = preprocess_dict(choices, processor)
+    proc_choices = preprocess_dict(choices, processor, &arena, c_workers)
 
     cdef vector[DictMatchElem[int64_t]] results = extract_dict_impl[int64_t](
         scorer_kwargs, scorer_flags, scorer, proc_query, proc_choices,
         get_score_cutoff_i64(score_cutoff, scorer_flags),
-        get_score_cutoff_i64(score_hint, scorer_flags)
+        get_score_cutoff_i64(score_hint, scorer_flags),
+        limit,
+        c_workers
     )
 
     # due to score_cutoff not always completely filled
-    if limit > <int64_t>results.size():
-        limit = <int64_t>results.size()
-
-    if limit >= <int64_t>results.size():
-        algorithm.sort(results.begin(), results.end(), ExtractComp(scorer_flags))
-    else:
-        algorithm.partial_sort(results.begin(), results.begin() + <ptrdiff_t>limit, results.end(), ExtractComp(scorer_flags))
-        results.resize(limit)
+    limit = <int64_t>results.size()
 
     # copy elements into Python List
     result_list = PyList_New(<Py_ssize_t>limit)
@@ -777,17 +1333,18 @@ cdef inline extract_dict(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
     flags = scorer_flags.flags
 
     if flags & RF_SCORER_FLAG_RESULT_F64:
         return extract_dict_f64(
-            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs
+            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs, c_workers
         )
     elif flags & RF_SCORER_FLAG_RESULT_I64:
         return extract_dict_i64(
-            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs
+            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs, c_workers
         )
 
     raise ValueError("scorer does not properly use the C-API")
@@ -801,26 +1358,23 @@ cdef inline extract_list_f64(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
+    cdef StringArena arena
     proc_query = move(RF_StringWrapper(conv_sequence(query)))
-    proc_choices = preprocess_list(choices, processor)
+    proc_choices = preprocess_list(choices, processor, &arena, c_workers)
 
     cdef vector[ListMatchElem[double]] results = extract_list_impl[double](
         scorer_kwargs, scorer_flags, scorer, proc_query, proc_choices,
         get_score_cutoff_f64(score_cutoff, scorer_flags),
-        get_score_cutoff_f64(score_hint, scorer_flags)
+        get_score_cutoff_f64(score_hint, scorer_flags),
+        limit,
+        c_workers
     )
 
     # due to score_cutoff not always completely filled
-    if limit > <int64_t>results.size():
-        limit = <int64_t>results.size()
-
-    if limit >= <int64_t>results.size():
-        algorithm.sort(results.begin(), results.end(), ExtractComp(scorer_flags))
-    else:
-        algorithm.partial_sort(results.begin(), results.begin() + <ptrdiff_t>limit, results.end(), ExtractComp(scorer_flags))
-        results.resize(limit)
+    limit = <int64_t>results.size()
 
     # copy elements into Python List
     result_list = PyList_New(<Py_ssize_t>limit)
@@ -840,26 +1394,23 @@ cdef inline extract_list_i64(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
+    cdef StringArena arena
     proc_query = move(RF_StringWrapper(conv_sequence(query)))
-    proc_choices = preprocess_list(choices, processor)
+    proc_choices = preprocess_list(choices, processor, &arena, c_workers)
 
     cdef vector[ListMatchElem[int64_t]] results = extract_list_impl[int64_t](
         scorer_kwargs, scorer_flags, scorer, proc_query, proc_choices,
         get_score_cutoff_i64(score_cutoff, scorer_flags),
-        get_score_cutoff_i64(score_hint, scorer_flags)
+        get_score_cutoff_i64(score_hint, scorer_flags),
+        limit,
+        c_workers
     )
 
     # due to score_cutoff not always completely filled
-    if limit > <int64_t>results.size():
-        limit = <int64_t>results.size()
-
-    if limit >= <int64_t>results.size():
-        algorithm.sort(results.begin(), results.end(), ExtractComp(scorer_flags))
-    else:
-        algorithm.partial_sort(results.begin(), results.begin() + <ptrdiff_t>limit, results.end(), ExtractComp(scorer_flags))
-        results.resize(limit)
+    limit = <int64_t>results.size()
 
     # copy elements into Python List
     result_list = PyList_New(<Py_ssize_t>limit)
@@ -879,17 +1430,121 @@ cdef inline extract_list(
     int64_t limit,
     score_cutoff,
     score_hint,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    int c_workers
 ):
     flags = scorer_flags.flags
 
     if flags & RF_SCORER_FLAG_RESULT_F64:
         return extract_list_f64(
-            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs
+            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs, c_workers
         )
     elif flags & RF_SCORER_FLAG_RESULT_I64:
         return extract_list_i64(
-            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs
+            query, choices, scorer, scorer_flags, processor, limit, score_cutoff, score_hint, scorer_kwargs, c_workers
+        )
+
+    raise ValueError("scorer does not properly use the C-API")
+
+
+cdef inline extract_corpus_f64(
+    query, Corpus corpus,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    int64_t limit,
+    score_cutoff,
+    score_hint,
+    const RF_Kwargs* scorer_kwargs,
+    const BKTree* bk_tree,
+    int c_workers
+):
+    proc_query = move(RF_StringWrapper(conv_sequence(query)))
+    # choices which are None are skipped, so this works with scorers which do not support None
+    cdef const vector[RF_StringWrapper]* proc_choices = &corpus.proc_choices
+
+    cdef vector[IndexMatchElem[double]] results = extract_corpus_impl[double](
+        scorer_kwargs, scorer_flags, scorer, proc_query, dereference(proc_choices), corpus.qgram_index, bk_tree,
+        corpus.get_char_signatures(scorer_flags), corpus.get_length_buckets(scorer_flags),
+        get_score_cutoff_f64(score_cutoff, scorer_flags),
+        get_score_cutoff_f64(score_hint, scorer_flags),
+        limit,
+        c_workers
+    )
+
+    # due to score_cutoff not always completely filled
+    limit = <int64_t>results.size()
+
+    # copy elements into Python List
+    result_list = PyList_New(<Py_ssize_t>limit)
+    for i in range(limit):
+        index = results[i].index
+        key = index if corpus.keys is None else corpus.keys[index]
+        result_item = (corpus.get_choice(index), results[i].score, key)
+        Py_INCREF(result_item)
+        PyList_SET_ITEM(result_list, <Py_ssize_t>i, result_item)
+
+    return result_list
+
+
+cdef inline extract_corpus_i64(
+    query, Corpus corpus,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    int64_t limit,
+    score_cutoff,
+    score_hint,
+    const RF_Kwargs* scorer_kwargs,
+    const BKTree* bk_tree,
+    int c_workers
+):
+    proc_query = move(RF_StringWrapper(conv_sequence(query)))
+    # choices which are None are skipped, so this works with scorers which do not support None
+    cdef const vector[RF_StringWrapper]* proc_choices = &corpus.proc_choices
+
+    cdef vector[IndexMatchElem[int64_t]] results = extract_corpus_impl[int64_t](
+        scorer_kwargs, scorer_flags, scorer, proc_query, dereference(proc_choices), corpus.qgram_index, bk_tree,
+        corpus.get_char_signatures(scorer_flags), corpus.get_length_buckets(scorer_flags),
+        get_score_cutoff_i64(score_cutoff, scorer_flags),
+        get_score_cutoff_i64(score_hint, scorer_flags),
+        limit,
+        c_workers
+    )
+
+    # due to score_cutoff not always completely filled
+    limit = <int64_t>results.size()
+
+    # copy elements into Python List
+    result_list = PyList_New(<Py_ssize_t>limit)
+    for i in range(limit):
+        index = results[i].index
+        key = index if corpus.keys is None else corpus.keys[index]
+        result_item = (corpus.get_choice(index), results[i].score, key)
+        Py_INCREF(result_item)
+        PyList_SET_ITEM(result_list, <Py_ssize_t>i, result_item)
+
+    return result_list
+
+
+cdef inline extract_corpus(
+    query, Corpus corpus,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    int64_t limit,
+    score_cutoff,
+    score_hint,
+    const RF_Kwargs* scorer_kwargs,
+    const BKTree* bk_tree,
+    int c_workers
+):
+    flags = scorer_flags.flags
+
+    if flags & RF_SCORER_FLAG_RESULT_F64:
+        return extract_corpus_f64(
+            query, corpus, scorer, scorer_flags, limit, score_cutoff, score_hint, scorer_kwargs, bk_tree, c_workers
+        )
+    elif flags & RF_SCORER_FLAG_RESULT_I64:
+        return extract_corpus_i64(
+            query, corpus, scorer, scorer_flags, limit, score_cutoff, score_hint, scorer_kwargs, bk_tree, c_workers
         )
 
     raise ValueError("scorer does not properly use the C-API")
@@ -950,9 +1605,10 @@ cdef inline py_extract_list(query, choices, scorer, processor, int64_t limit, do
         return heapq.nsmallest(limit, result_list, key=lambda i: i[1])
 
 
-def extract(query, choices, *, scorer=WRatio, processor=None, limit=5, score_cutoff=None, score_hint=None, scorer_kwargs=None):
+def extract(query, choices, *, scorer=WRatio, processor=None, limit=5, score_cutoff=None, score_hint=None, workers=1, scorer_kwargs=None):
     cdef RF_Scorer* scorer_context = NULL
     cdef RF_ScorerFlags scorer_flags
+    cdef int c_workers = workers
     scorer_kwargs = scorer_kwargs.copy() if scorer_kwargs else {}
 
     if is_none(query):
@@ -976,19 +1632,28 @@ def extract(query, choices, *, scorer=WRatio, processor=None, limit=5, score_cut
     if PyCapsule_IsValid(scorer_capsule, NULL):
         scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
 
-    if scorer_context and scorer_context.version == SCORER_STRUCT_VERSION:
+    if is_supported_scorer(scorer_context):
         kwargs_context = RF_KwargsWrapper()
         scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
         scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
 
-        if hasattr(choices, "items"):
+        if isinstance(choices, Corpus):
+            return extract_corpus(query, choices, scorer_context, &scorer_flags,
+                limit, score_cutoff, score_hint, &kwargs_context.kwargs,
+                (<Corpus>choices).get_bk_tree(scorer_context, scorer_kwargs), c_workers)
+        elif hasattr(choices, "items"):
             return extract_dict(query, choices, scorer_context, &scorer_flags,
-                processor, limit, score_cutoff, score_hint, &kwargs_context.kwargs)
+                processor, limit, score_cutoff, score_hint, &kwargs_context.kwargs, c_workers)
         else:
             return extract_list(query, choices, scorer_context, &scorer_flags,
-                processor, limit, score_cutoff, score_hint, &kwargs_context.kwargs)
+                processor, limit, score_cutoff, score_hint, &kwargs_context.kwargs, c_workers)
 
 
+    # the corpus only stores the choices preprocessed for the C-API
+    if isinstance(choices, Corpus):
+        processor = (<Corpus>choices).processor
+        choices = (<Corpus>choices).as_choices()
+
     worst_score, optimal_score = get_scorer_flags_py(scorer, scorer_kwargs)
     # the scorer has to be called through Python
     if score_cutoff is None:
@@ -1239,11 +1904,16 @@ def extract_iter(query, choices, *, scorer=WRatio, processor=None, score_cutoff=
     if callable(processor):
         query = processor(query)
 
+    # the choices are yielded one by one, so the preprocessing of the corpus can not be reused
+    if isinstance(choices, Corpus):
+        processor = (<Corpus>choices).processor
+        choices = (<Corpus>choices).as_choices()
+
     scorer_capsule = getattr(scorer, '_RF_Scorer', scorer)
     if PyCapsule_IsValid(scorer_capsule, NULL):
         scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
 
-    if scorer_context and scorer_context.version == SCORER_STRUCT_VERSION:
+    if is_supported_scorer(scorer_context):
         kwargs_context = RF_KwargsWrapper()
         scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
         scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
@@ -1282,6 +1952,30 @@ def extract_iter(query, choices, *, scorer=WRatio, processor=None, score_cutoff=
         yield from py_extract_iter_list(worst_score, optimal_score)
 
 
+def default_process_list(sentences, *, int workers=1):
+    """implementation of utils.default_process_list"""
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] proc_sentences = preprocess(sentences, default_process, False, &arena, workers)
+    cdef RF_String proc_str
+    cdef size_t i
+
+    result = PyList_New(<Py_ssize_t>proc_sentences.size())
+    for i in range(proc_sentences.size()):
+        proc_str = proc_sentences[i].string
+        proc_sentence = PyUnicode_FromKindAndData(1 << <int>proc_str.kind, proc_str.data, <Py_ssize_t>proc_str.length)
+        Py_INCREF(proc_sentence)
+        PyList_SET_ITEM(result, <Py_ssize_t>i, proc_sentence)
+
+    return result
+
+
+def _shutdown_thread_pool():
+    with nogil:
+        thread_pool_shutdown()
+
+atexit.register(_shutdown_thread_pool)
+
+
 FLOAT32 = MatrixType.FLOAT32
 FLOAT64 = MatrixType.FLOAT64
 INT8 = MatrixType.INT8
@@ -1310,46 +2004,6 @@ cdef inline vector[PyObjectWrapper] preprocess_py(queries, processor) except *:
 
     return move(proc_queries)
 
-cdef inline vector[RF_StringWrapper] preprocess(const RF_ScorerFlags* scorer_flags, queries, processor) except *:
-    cdef vector[RF_StringWrapper] proc_queries
-    cdef int64_t queries_len = <int64_t>len(queries)
-    cdef RF_String proc_str
-    cdef RF_Preprocessor* processor_context = NULL
-    flags = scorer_flags.flags
-    proc_queries.reserve(queries_len)
-
-    # No processor
-    if not processor:
-        for query in queries:
-            if is_none(query) and flags & RF_SCORER_NONE_IS_WORST_SCORE:
-                proc_queries.emplace_back()
-            else:
-                proc_queries.emplace_back(conv_sequence(query), <PyObject*>query)
-    else:
-        processor_capsule = getattr(processor, '_RF_Preprocess', processor)
-        if PyCapsule_IsValid(processor_capsule, NULL):
-            processor_context = <RF_Preprocessor*>PyCapsule_GetPointer(processor_capsule, NULL)
-
-        # use RapidFuzz C-Api
-        if processor_context != NULL and processor_context.version == SCORER_STRUCT_VERSION:
-            for query in queries:
-                if is_none(query) and flags & RF_SCORER_NONE_IS_WORST_SCORE:
-                    proc_queries.emplace_back()
-                else:
-                    processor_context.preprocess(query, &proc_str)
-                    proc_queries.emplace_back(proc_str, <PyObject*>query)
-
-        # Call Processor through Python
-        else:
-            for query in queries:
-                if is_none(query) and flags & RF_SCORER_NONE_IS_WORST_SCORE:
-                    proc_queries.emplace_back()
-                else:
-                    proc_query = processor(query)
-                    proc_queries.emplace_back(conv_sequence(proc_query), <PyObject*>proc_query)
-
-    return move(proc_queries)
-
 cdef inline MatrixType dtype_to_type_num_f64(dtype) except MatrixType.UNDEFINED:
     if dtype is None:
         return MatrixType.FLOAT32
@@ -1375,6 +2029,22 @@ cdef inline MatrixType dtype_to_type_num_py(dtype, scorer, dict scorer_kwargs) e
 
     return MatrixType.FLOAT32
 
+cdef inline double uint8_score_scale_py(scorer, dict scorer_kwargs, MatrixType dtype) except -1:
+    # scores of floating point scorers are stored as 0-100 in uint8 matrices
+    if dtype != MatrixType.UINT8:
+        return 1.0
+
+    params = getattr(scorer, "_RF_ScorerPy", None)
+    if params is None:
+        return 1.0
+
+    flags = params["get_scorer_flags"](**scorer_kwargs)
+    if <int>flags["flags"] & RF_SCORER_FLAG_RESULT_I64:
+        return 1.0
+
+    max_score = max(flags["optimal_score"], flags["worst_score"])
+    return 100.0 / max_score if max_score > 0 else 1.0
+
 
 from cpython cimport Py_buffer
 from libcpp.vector cimport vector
@@ -1384,12 +2054,37 @@ cdef class Matrix:
     cdef Py_ssize_t shape[2]
     cdef Py_ssize_t strides[2]
     cdef RfMatrix matrix
+    # buffer of the out argument of cdist, which the matrix writes into
+    cdef Py_buffer out_view
+    cdef bool has_out_view
+
+    def __dealloc__(self):
+        if self.has_out_view:
+            PyBuffer_Release(&self.out_view)
+
+    cdef view_out(self, out, MatrixType dtype, size_t rows, size_t cols):
+        cdef Py_buffer* view = &self.out_view
+        cdef Py_ssize_t itemsize
+        PyObject_GetBuffer(out, view, PyBUF_RECORDS_RO)
+        self.has_out_view = True
+
+        if view.readonly:
+            raise ValueError("out has to be writable")
+        if view.ndim != 2 or <size_t>view.shape[0] != rows or <size_t>view.shape[1] != cols:
+            raise ValueError(f"out has to be a matrix with the shape ({rows}, {cols})")
+
+        self.matrix = RfMatrix(dtype, rows, cols, view.buf, view.strides[0], view.strides[1])
+        itemsize = self.matrix.get_dtype_size()
+        if view.itemsize != itemsize:
+            raise ValueError("the dtype of out does not match dtype")
+        if (<size_t>view.buf) % itemsize or view.strides[0] % itemsize or view.strides[1] % itemsize:
+            raise ValueError("out has to be aligned")
 
     def __getbuffer__(self, Py_buffer *buffer, int flags):
         self.shape[0] = self.matrix.m_rows
         self.shape[1] = self.matrix.m_cols
-        self.strides[1] = self.matrix.get_dtype_size()
-        self.strides[0] = self.matrix.m_cols * self.strides[1]
+        self.strides[0] = self.matrix.m_row_stride
+        self.strides[1] = self.matrix.m_col_stride
 
         buffer.buf = <char *>self.matrix.m_matrix
         buffer.format = <char *>self.matrix.get_format()
@@ -1406,6 +2101,30 @@ cdef class Matrix:
     def __releasebuffer__(self, Py_buffer *buffer):
         pass
 
+cdef Matrix create_matrix(out, MatrixType dtype, size_t rows, size_t cols):
+    """
+    matrix the results of cdist are written into. This is either a new matrix or a view
+    of the out argument, so the results are written into it in place
+    """
+    cdef Matrix matrix = Matrix()
+    if out is None:
+        matrix.matrix = RfMatrix(dtype, rows, cols)
+    else:
+        matrix.view_out(out, dtype, rows, cols)
+    return matrix
+
+cdef inline const vector[RF_StringWrapper]* preprocess_cdist(
+    const RF_ScorerFlags* scorer_flags, queries, processor, vector[RF_StringWrapper]* storage, StringArena* arena,
+    int workers
+) except NULL:
+    # a Corpus already holds the preprocessed strings
+    if isinstance(queries, Corpus):
+        return (<Corpus>queries).get_proc_choices(scorer_flags)
+
+    storage[0] = move(preprocess(
+        queries, processor, <bool>(scorer_flags.flags & RF_SCORER_NONE_IS_WORST_SCORE), arena, workers))
+    return storage
+
 cdef Matrix cdist_two_lists(
     queries, choices,
     RF_Scorer* scorer,
@@ -1415,18 +2134,25 @@ cdef Matrix cdist_two_lists(
     score_hint,
     dtype,
     int c_workers,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    out
 ):
-    proc_queries = preprocess(scorer_flags, queries, processor)
-    proc_choices = preprocess(scorer_flags, choices, processor)
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] queries_storage
+    cdef vector[RF_StringWrapper] choices_storage
+    cdef const vector[RF_StringWrapper]* proc_queries = preprocess_cdist(
+        scorer_flags, queries, processor, &queries_storage, &arena, c_workers)
+    cdef const vector[RF_StringWrapper]* proc_choices = preprocess_cdist(
+        scorer_flags, choices, processor, &choices_storage, &arena, c_workers)
     flags = scorer_flags.flags
-    cdef Matrix matrix = Matrix()
+    cdef Matrix matrix
 
     if flags & RF_SCORER_FLAG_RESULT_F64:
-        matrix.matrix = cdist_two_lists_impl[double](
+        matrix = create_matrix(out, dtype_to_type_num_f64(dtype), proc_queries.size(), proc_choices.size())
+        cdist_two_lists_impl[double](
             scorer_flags,
-            scorer_kwargs, scorer, proc_queries, proc_choices,
-            dtype_to_type_num_f64(dtype),
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            matrix.matrix,
             c_workers,
             get_score_cutoff_f64(score_cutoff, scorer_flags),
             get_score_cutoff_f64(score_hint, scorer_flags),
@@ -1434,10 +2160,11 @@ cdef Matrix cdist_two_lists(
         )
 
     elif flags & RF_SCORER_FLAG_RESULT_I64:
-        matrix.matrix = cdist_two_lists_impl[int64_t](
+        matrix = create_matrix(out, dtype_to_type_num_i64(dtype), proc_queries.size(), proc_choices.size())
+        cdist_two_lists_impl[int64_t](
             scorer_flags,
-            scorer_kwargs, scorer, proc_queries, proc_choices,
-            dtype_to_type_num_i64(dtype),
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            matrix.matrix,
             c_workers,
             get_score_cutoff_i64(score_cutoff, scorer_flags),
             get_score_cutoff_i64(score_hint, scorer_flags),
@@ -1457,17 +2184,22 @@ cdef Matrix cdist_single_list(
     score_hint,
     dtype,
     int c_workers,
-    const RF_Kwargs* scorer_kwargs
+    const RF_Kwargs* scorer_kwargs,
+    out
 ):
-    proc_queries = preprocess(scorer_flags, queries, processor)
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] queries_storage
+    cdef const vector[RF_StringWrapper]* proc_queries = preprocess_cdist(
+        scorer_flags, queries, processor, &queries_storage, &arena, c_workers)
     flags = scorer_flags.flags
-    cdef Matrix matrix = Matrix()
+    cdef Matrix matrix
 
     if flags & RF_SCORER_FLAG_RESULT_F64:
-        matrix.matrix = cdist_single_list_impl[double](
+        matrix = create_matrix(out, dtype_to_type_num_f64(dtype), proc_queries.size(), proc_queries.size())
+        cdist_single_list_impl[double](
             scorer_flags,
-            scorer_kwargs, scorer, proc_queries,
-            dtype_to_type_num_f64(dtype),
+            scorer_kwargs, scorer, dereference(proc_queries),
+            matrix.matrix,
             c_workers,
             get_score_cutoff_f64(score_cutoff, scorer_flags),
             get_score_cutoff_f64(score_hint, scorer_flags),
@@ -1475,10 +2207,11 @@ cdef Matrix cdist_single_list(
         )
 
     elif flags & RF_SCORER_FLAG_RESULT_I64:
-        matrix.matrix = cdist_single_list_impl[int64_t](
+        matrix = create_matrix(out, dtype_to_type_num_i64(dtype), proc_queries.size(), proc_queries.size())
+        cdist_single_list_impl[int64_t](
             scorer_flags,
-            scorer_kwargs, scorer, proc_queries,
-            dtype_to_type_num_i64(dtype),
+            scorer_kwargs, scorer, dereference(proc_queries),
+            matrix.matrix,
             c_workers,
             get_score_cutoff_i64(score_cutoff, scorer_flags),
             get_score_cutoff_i64(score_hint, scorer_flags),
@@ -1492,27 +2225,35 @@ cdef Matrix cdist_single_list(
 
 @cython.boundscheck(False)
 @cython.wraparound(False)
-cdef cdist_py(queries, choices, scorer, processor, score_cutoff, dtype, workers, dict scorer_kwargs):
+cdef cdist_py(queries, choices, scorer, processor, score_cutoff, dtype, workers, dict scorer_kwargs, out):
     # todo this should handle two similar sequences more efficiently
 
-    proc_queries = preprocess_py(queries, processor)
-    proc_choices = preprocess_py(choices, processor)
+    # the corpus only stores the choices preprocessed for the C-API
+    if isinstance(queries, Corpus):
+        proc_queries = preprocess_py((<Corpus>queries).choices, (<Corpus>queries).processor)
+    else:
+        proc_queries = preprocess_py(queries, processor)
+
+    if isinstance(choices, Corpus):
+        proc_choices = preprocess_py((<Corpus>choices).choices, (<Corpus>choices).processor)
+    else:
+        proc_choices = preprocess_py(choices, processor)
     cdef double score
-    cdef Matrix matrix = Matrix()
     c_dtype = dtype_to_type_num_py(dtype, scorer, scorer_kwargs)
-    matrix.matrix = RfMatrix(c_dtype, proc_queries.size(), proc_choices.size())
+    cdef double scale = uint8_score_scale_py(scorer, scorer_kwargs, c_dtype)
+    cdef Matrix matrix = create_matrix(out, c_dtype, proc_queries.size(), proc_choices.size())
 
     scorer_kwargs["score_cutoff"] = score_cutoff
 
     for i in range(proc_queries.size()):
         for j in range(proc_choices.size()):
             score = scorer(<object>proc_queries[i].obj, <object>proc_choices[j].obj, **scorer_kwargs)
-            matrix.matrix.set(i, j, score)
+            matrix.matrix.set(i, j, score * scale)
 
     return matrix
 
 
-def cdist(queries, choices, *, scorer=ratio, processor=None, score_cutoff=None, score_hint=None, dtype=None, workers=1, scorer_kwargs=None):
+def cdist(queries, choices, *, scorer=ratio, processor=None, score_cutoff=None, score_hint=None, dtype=None, workers=1, scorer_kwargs=None, out=None):
     cdef RF_Scorer* scorer_context = NULL
     cdef RF_ScorerFlags scorer_flags
     cdef bool is_orig_scorer
@@ -1525,19 +2266,280 @@ def cdist(queries, choices, *, scorer=ratio, processor=None, score_cutoff=None,
 
     is_orig_scorer = getattr(scorer, '_RF_OriginalScorer', None) is scorer
 
-    if is_orig_scorer and scorer_context and scorer_context.version == SCORER_STRUCT_VERSION:
+    if is_orig_scorer and is_supported_scorer(scorer_context):
         kwargs_context = RF_KwargsWrapper()
         scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
         scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
 
         # scorer(queries[i], choices[j]) == scorer(queries[j], choices[i])
         if scorer_flags.flags & RF_SCORER_FLAG_SYMMETRIC and queries is choices:
-            return cdist_single_list(
+            matrix = cdist_single_list(
                 queries, scorer_context, &scorer_flags, processor,
-                score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs)
+                score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs, out)
         else:
-            return cdist_two_lists(
+            matrix = cdist_two_lists(
                 queries, choices, scorer_context, &scorer_flags, processor,
-                score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs)
+                score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs, out)
+    else:
+        matrix = cdist_py(queries, choices, scorer, processor, score_cutoff, dtype, workers, scorer_kwargs, out)
+
+    # the results were written into out in place
+    return matrix if out is None else out
+
+
+cdef sparse_matrix(RfSparseMatrix& sparse):
+    cdef Matrix data = Matrix()
+    cdef Matrix indices = Matrix()
+    cdef Matrix indptr = Matrix()
+    data.matrix = move(sparse.m_data)
+    indices.matrix = move(sparse.m_indices)
+    indptr.matrix = move(sparse.m_indptr)
+    return data, indices, indptr
+
+cdef cdist_sparse_two_lists(
+    queries,
+    choices,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    processor,
+    score_cutoff,
+    score_hint,
+    dtype,
+    int c_workers,
+    const RF_Kwargs* scorer_kwargs
+):
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] queries_storage
+    cdef vector[RF_StringWrapper] choices_storage
+    cdef const vector[RF_StringWrapper]* proc_queries = preprocess_cdist(
+        scorer_flags, queries, processor, &queries_storage, &arena, c_workers)
+    cdef const vector[RF_StringWrapper]* proc_choices = preprocess_cdist(
+        scorer_flags, choices, processor, &choices_storage, &arena, c_workers)
+    flags = scorer_flags.flags
+    cdef RfSparseMatrix sparse
+
+    if flags & RF_SCORER_FLAG_RESULT_F64:
+        sparse = cdist_sparse_impl[double](
+            scorer_flags,
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            dtype_to_type_num_f64(dtype),
+            c_workers,
+            get_score_cutoff_f64(score_cutoff, scorer_flags),
+            get_score_cutoff_f64(score_hint, scorer_flags),
+            scorer_flags.worst_score.f64
+        )
+
+    elif flags & RF_SCORER_FLAG_RESULT_I64:
+        sparse = cdist_sparse_impl[int64_t](
+            scorer_flags,
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            dtype_to_type_num_i64(dtype),
+            c_workers,
+            get_score_cutoff_i64(score_cutoff, scorer_flags),
+            get_score_cutoff_i64(score_hint, scorer_flags),
+            scorer_flags.worst_score.i64
+        )
+    else:
+        raise ValueError("scorer does not properly use the C-API")
+
+    return sparse_matrix(sparse)
+
+cdef cdist_sparse_py(queries, choices, scorer, processor, score_cutoff, dtype, dict scorer_kwargs):
+    if isinstance(queries, Corpus):
+        proc_queries = preprocess_py((<Corpus>queries).choices, (<Corpus>queries).processor)
+    else:
+        proc_queries = preprocess_py(queries, processor)
+
+    if isinstance(choices, Corpus):
+        proc_choices = preprocess_py((<Corpus>choices).choices, (<Corpus>choices).processor)
+    else:
+        proc_choices = preprocess_py(choices, processor)
+
+    worst_score, optimal_score = get_scorer_flags_py(scorer, scorer_kwargs)
+    cdef bool lowest_score_worst = optimal_score > worst_score
+    c_dtype = dtype_to_type_num_py(dtype, scorer, scorer_kwargs)
+    cdef double scale = uint8_score_scale_py(scorer, scorer_kwargs, c_dtype)
+    scorer_kwargs["score_cutoff"] = score_cutoff
+
+    data = []
+    indices = []
+    indptr = [0]
+    for i in range(proc_queries.size()):
+        for j in range(proc_choices.size()):
+            score = scorer(<object>proc_queries[i].obj, <object>proc_choices[j].obj, **scorer_kwargs)
+            if score_cutoff is None or (score >= score_cutoff if lowest_score_worst else score <= score_cutoff):
+                data.append(score)
+                indices.append(j)
+
+        indptr.append(len(data))
+
+    cdef RfSparseMatrix sparse
+    sparse.m_data = RfMatrix(c_dtype, 1, len(data))
+    sparse.m_indices = RfMatrix(MatrixType.INT64, 1, len(indices))
+    sparse.m_indptr = RfMatrix(MatrixType.INT64, 1, len(indptr))
+    for i in range(len(data)):
+        sparse.m_data.set(0, i, <double>data[i] * scale)
+        sparse.m_indices.set(0, i, <int64_t>indices[i])
+    for i in range(len(indptr)):
+        sparse.m_indptr.set(0, i, <int64_t>indptr[i])
+
+    return sparse_matrix(sparse)
+
+
+def cdist_sparse(queries, choices, *, scorer=ratio, processor=None, score_cutoff=None, score_hint=None, dtype=None, workers=1, scorer_kwargs=None):
+    cdef RF_Scorer* scorer_context = NULL
+    cdef RF_ScorerFlags scorer_flags
+    cdef bool is_orig_scorer
+
+    scorer_kwargs = scorer_kwargs.copy() if scorer_kwargs else {}
+
+    scorer_capsule = getattr(scorer, '_RF_Scorer', scorer)
+    if PyCapsule_IsValid(scorer_capsule, NULL):
+        scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
+
+    is_orig_scorer = getattr(scorer, '_RF_OriginalScorer', None) is scorer
+
+    if is_orig_scorer and is_supported_scorer(scorer_context):
+        kwargs_context = RF_KwargsWrapper()
+        scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
+        scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
+
+        return cdist_sparse_two_lists(
+            queries, choices, scorer_context, &scorer_flags, processor,
+            score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs)
+
+    return cdist_sparse_py(queries, choices, scorer, processor, score_cutoff, dtype, scorer_kwargs)
+
+
+cdef topk_matrix(RfTopKMatrix& topk):
+    cdef Matrix indices = Matrix()
+    cdef Matrix scores = Matrix()
+    indices.matrix = move(topk.m_indices)
+    scores.matrix = move(topk.m_scores)
+    return indices, scores
+
+cdef cdist_topk_two_lists(
+    queries,
+    choices,
+    int64_t limit,
+    RF_Scorer* scorer,
+    const RF_ScorerFlags* scorer_flags,
+    processor,
+    score_cutoff,
+    score_hint,
+    dtype,
+    int c_workers,
+    const RF_Kwargs* scorer_kwargs
+):
+    cdef StringArena arena
+    cdef vector[RF_StringWrapper] queries_storage
+    cdef vector[RF_StringWrapper] choices_storage
+    cdef const vector[RF_StringWrapper]* proc_queries = preprocess_cdist(
+        scorer_flags, queries, processor, &queries_storage, &arena, c_workers)
+    cdef const vector[RF_StringWrapper]* proc_choices = preprocess_cdist(
+        scorer_flags, choices, processor, &choices_storage, &arena, c_workers)
+    flags = scorer_flags.flags
+    cdef RfTopKMatrix topk
+
+    if flags & RF_SCORER_FLAG_RESULT_F64:
+        topk = cdist_topk_impl[double](
+            scorer_flags,
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            limit,
+            dtype_to_type_num_f64(dtype),
+            c_workers,
+            get_score_cutoff_f64(score_cutoff, scorer_flags),
+            get_score_cutoff_f64(score_hint, scorer_flags),
+            scorer_flags.worst_score.f64
+        )
+
+    elif flags & RF_SCORER_FLAG_RESULT_I64:
+        topk = cdist_topk_impl[int64_t](
+            scorer_flags,
+            scorer_kwargs, scorer, dereference(proc_queries), dereference(proc_choices),
+            limit,
+            dtype_to_type_num_i64(dtype),
+            c_workers,
+            get_score_cutoff_i64(score_cutoff, scorer_flags),
+            get_score_cutoff_i64(score_hint, scorer_flags),
+            scorer_flags.worst_score.i64
+        )
+    else:
+        raise ValueError("scorer does not properly use the C-API")
+
+    return topk_matrix(topk)
+
+cdef cdist_topk_py(queries, choices, int64_t limit, scorer, processor, score_cutoff, dtype, dict scorer_kwargs):
+    if limit <= 0:
+        raise ValueError("limit has to be > 0")
+
+    if isinstance(queries, Corpus):
+        proc_queries = preprocess_py((<Corpus>queries).choices, (<Corpus>queries).processor)
+    else:
+        proc_queries = preprocess_py(queries, processor)
+
+    if isinstance(choices, Corpus):
+        proc_choices = preprocess_py((<Corpus>choices).choices, (<Corpus>choices).processor)
+    else:
+        proc_choices = preprocess_py(choices, processor)
+
+    worst_score, optimal_score = get_scorer_flags_py(scorer, scorer_kwargs)
+    cdef bool lowest_score_worst = optimal_score > worst_score
+    c_dtype = dtype_to_type_num_py(dtype, scorer, scorer_kwargs)
+    cdef double scale = uint8_score_scale_py(scorer, scorer_kwargs, c_dtype)
+    scorer_kwargs["score_cutoff"] = score_cutoff
+
+    cdef RfTopKMatrix topk
+    topk.m_indices = RfMatrix(MatrixType.INT64, proc_queries.size(), limit)
+    topk.m_scores = RfMatrix(c_dtype, proc_queries.size(), limit)
+    for i in range(proc_queries.size()):
+        matches = []
+        query = <object>proc_queries[i].obj
+        if not is_none(query):
+            for j in range(proc_choices.size()):
+                choice = <object>proc_choices[j].obj
+                if is_none(choice):
+                    continue
+
+                score = scorer(query, choice, **scorer_kwargs)
+                if score_cutoff is None or (score >= score_cutoff if lowest_score_worst else score <= score_cutoff):
+                    matches.append((-score if lowest_score_worst else score, j, score))
+
+        matches = heapq.nsmallest(limit, matches)
+        for k in range(limit):
+            if k < len(matches):
+                topk.m_indices.set(i, k, <int64_t>matches[k][1])
+                topk.m_scores.set(i, k, <double>matches[k][2] * scale)
+            else:
+                topk.m_indices.set(i, k, <int64_t>-1)
+                if isinstance(worst_score, int):
+                    topk.m_scores.set(i, k, saturate_score[int64_t](<int64_t>worst_score, c_dtype))
+                else:
+                    topk.m_scores.set(i, k, saturate_score[double](<double>worst_score * scale, c_dtype))
+
+    return topk_matrix(topk)
+
+
+def cdist_topk(queries, choices, *, limit=5, scorer=ratio, processor=None, score_cutoff=None, score_hint=None, dtype=None, workers=1, scorer_kwargs=None):
+    cdef RF_Scorer* scorer_context = NULL
+    cdef RF_ScorerFlags scorer_flags
+    cdef bool is_orig_scorer
+
+    scorer_kwargs = scorer_kwargs.copy() if scorer_kwargs else {}
+
+    scorer_capsule = getattr(scorer, '_RF_Scorer', scorer)
+    if PyCapsule_IsValid(scorer_capsule, NULL):
+        scorer_context = <RF_Scorer*>PyCapsule_GetPointer(scorer_capsule, NULL)
+
+    is_orig_scorer = getattr(scorer, '_RF_OriginalScorer', None) is scorer
+
+    if is_orig_scorer and is_supported_scorer(scorer_context):
+        kwargs_context = RF_KwargsWrapper()
+        scorer_context.kwargs_init(&kwargs_context.kwargs, scorer_kwargs)
+        scorer_context.get_scorer_flags(&kwargs_context.kwargs, &scorer_flags)
+
+        return cdist_topk_two_lists(
+            queries, choices, limit, scorer_context, &scorer_flags, processor,
+            score_cutoff, score_hint, dtype, workers, &kwargs_context.kwargs)
 
-    return cdist_py(queries, choices, scorer, processor, score_cutoff, dtype, workers, scorer_kwargs)
+    return cdist_topk_py(queries, choices, limit, scorer, processor, score_cutoff, dtype, scorer_kwargs)
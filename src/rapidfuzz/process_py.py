@@ -4,8 +4,10 @@
 from __future__ import annotations
 
 import heapq
+import struct
+import sys
 from contextlib import suppress
-from math import isnan
+from math import floor, isnan
 from typing import (
     Any,
     Callable,
@@ -17,10 +19,10 @@ from typing import (
     overload,
 )
 
-from rapidfuzz._utils import ScorerFlag
+from rapidfuzz._utils import ScorerFlag, processor_name
 from rapidfuzz.fuzz import WRatio, ratio
 
-__all__ = ["extract", "extract_iter", "extractOne", "cdist"]
+__all__ = ["extract", "extract_iter", "extractOne", "cdist", "cdist_sparse", "cdist_topk", "Corpus"]
 
 
 def _get_scorer_flags_py(scorer: Any, scorer_kwargs: dict[str, Any]) -> tuple[int, int]:
@@ -41,6 +43,361 @@ def _is_none(s: Any) -> bool:
     return False
 
 
+class Corpus:
+    """
+    Collection of choices, which are preprocessed once and can then be passed as
+    `choices` to extract, extractOne and cdist multiple times.
+
+    Parameters
+    ----------
+    choices : Collection[Sequence[Hashable]] | Mapping[Sequence[Hashable]]
+        list of all strings the query should be compared with or dict with a mapping
+        {<result>: <string to compare>}
+    processor : Callable, optional
+        Optional callable that is used to preprocess the choices. The processor
+        passed to extract, extractOne and cdist is only applied to the query.
+        Default is None, which deactivates this behaviour.
+    qgram_size : int, optional
+        length of the q-grams of an inverted index built over the processed choices.
+        For scorers like Levenshtein or Indel, extract and extractOne use it to only score
+        choices sharing enough q-grams with the query to reach the score_cutoff. This is
+        only implemented in the C++ implementation. Default is None, which does not build
+        an index.
+    workers : int, optional
+        The choices are subdivided into workers sections and preprocessed in parallel.
+        Supply -1 to use all available CPU cores.
+        This argument is only available for `utils.default_process` so far, which is applied
+        to all choices in a single call releasing the Python GIL.
+    """
+
+    def __init__(
+        self,
+        choices: Collection[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None],
+        *,
+        processor: Callable[..., Sequence[Hashable]] | None = None,
+        qgram_size: int | None = None,
+        workers: int = 1,
+    ):
+        _ = workers
+        self.keys: list[Any] | None
+        if hasattr(choices, "items"):
+            self.keys = list(choices.keys())  # type: ignore[union-attr]
+            self.choices = list(choices.values())  # type: ignore[union-attr]
+        else:
+            self.keys = None
+            self.choices = list(choices)
+
+        self.processor = processor
+        self._processed = processor is not None
+        self._proc_choices = [x if processor is None or _is_none(x) else processor(x) for x in self.choices]
+        self.qgram_size = _check_qgram_size(qgram_size)
+
+    def __len__(self) -> int:
+        return len(self.choices)
+
+    def __repr__(self) -> str:
+        return f"Corpus(len={len(self.choices)}, processor={self.processor!r})"
+
+    def build_bktree(self, scorer: Callable[..., int], *, scorer_kwargs: dict[str, Any] | None = None) -> None:
+        """
+        Builds a BK-tree over the processed choices, which is searched by extract and
+        extractOne when they are called with the same scorer and scorer_kwargs.
+        Only the parts of the tree, which can contain choices within the score_cutoff
+        or better than the current `limit` best matches, are compared with the query.
+        This is only implemented in the C++ implementation.
+
+        Parameters
+        ----------
+        scorer : Callable
+            distance adhering to the triangle inequality, like `Levenshtein.distance`
+            or `Indel.distance`.
+        scorer_kwargs : dict[str, Any], optional
+            any other named parameters are passed to the scorer.
+
+        Raises
+        ------
+        ValueError
+            If the scorer does not implement the RapidFuzz C-API or does not adhere
+            to the triangle inequality.
+        """
+        if not hasattr(scorer, "_RF_Scorer"):
+            msg = "BK-tree requires a scorer implementing the RapidFuzz C-API"
+            raise ValueError(msg)
+
+        scorer_kwargs = scorer_kwargs or {}
+        params = getattr(scorer, "_RF_ScorerPy", None)
+        flags = params["get_scorer_flags"](**scorer_kwargs)["flags"] if params is not None else 0
+        if (flags & ScorerFlag.TRIANGLE_INEQUALITY) != ScorerFlag.TRIANGLE_INEQUALITY or not (
+            flags & ScorerFlag.RESULT_I64
+        ):
+            msg = "BK-tree requires a distance adhering to the triangle inequality"
+            raise ValueError(msg)
+
+    def save(self, path: Any) -> None:
+        """
+        Stores the corpus in a binary file, which can be memory mapped by `Corpus.load`.
+        The file contains the choices, the output of the processor for each of them
+        and the name of the processor.
+
+        Parameters
+        ----------
+        path : str | os.PathLike
+            path of the file
+        """
+        if self.keys is not None:
+            msg = "only a Corpus created from a list of choices can be saved"
+            raise TypeError(msg)
+
+        for choice in self.choices:
+            if not _is_none(choice) and not isinstance(choice, str):
+                msg = "only a Corpus of strings can be saved"
+                raise TypeError(msg)
+
+        tables = [self.choices]
+        processor = ""
+        if self._processed:
+            tables.append(self._proc_choices)
+            processor = processor_name(self.processor)
+
+        with open(path, "wb") as f:
+            f.write(_write_corpus_file(tables, processor))
+
+    @classmethod
+    def load(
+        cls,
+        path: Any,
+        *,
+        processor: Callable[..., Sequence[Hashable]] | None = None,
+        qgram_size: int | None = None,
+    ) -> Corpus:
+        """
+        Loads a corpus file written by `Corpus.save`.
+
+        Parameters
+        ----------
+        path : str | os.PathLike
+            path of the file
+        processor : Callable, optional
+            processor the corpus was saved with. The processed choices are stored in
+            the file, so it is only compared with the name of the processor stored in it.
+        qgram_size : int, optional
+            length of the q-grams of an inverted index built over the processed choices.
+            See `Corpus`. Default is None, which does not build an index.
+
+        Returns
+        -------
+        Corpus
+
+        Raises
+        ------
+        ValueError
+            If the file is no valid corpus file or `processor` does not match the
+            processor the corpus was saved with.
+        """
+        with open(path, "rb") as f:
+            tables, saved_processor = _read_corpus_file(f.read())
+
+        # scorers apply the processor to the choices, so it has to match the processed choices
+        # stored in the file
+        if processor_name(processor) != saved_processor:
+            if not saved_processor:
+                msg = "the corpus file does not store processed choices"
+                raise ValueError(msg)
+            msg = f"the corpus file was saved with the processor {saved_processor}"
+            raise ValueError(msg)
+
+        corpus = cls.__new__(cls)
+        corpus.keys = None
+        corpus.choices = tables[0]
+        corpus.processor = processor
+        corpus._processed = len(tables) > 1
+        corpus._proc_choices = tables[-1]
+        corpus.qgram_size = _check_qgram_size(qgram_size)
+        return corpus
+
+
+def _check_qgram_size(qgram_size: int | None) -> int | None:
+    if qgram_size is not None and qgram_size < 1:
+        msg = "qgram_size has to be at least 1"
+        raise ValueError(msg)
+    return qgram_size
+
+
+# binary corpus file format. See corpus_file.hpp for a description of the layout
+_CORPUS_FILE_MAGIC = b"RFCORPUS"
+_CORPUS_FILE_VERSION = 2
+_CORPUS_FILE_BYTE_ORDER = 0x01020304
+_CORPUS_FILE_NONE = 0xFFFFFFFF
+_CORPUS_FILE_HEADER = struct.Struct("=8sIIQQQQ")
+_CORPUS_FILE_TABLE = struct.Struct("=7Q")
+_CORPUS_FILE_ENTRY = struct.Struct("=QQII")
+# strings are stored as Latin-1, UCS-2 or UCS-4 depending on their largest character
+_CORPUS_FILE_ENCODINGS = ("latin-1", f"utf-16-{sys.byteorder[0]}e", f"utf-32-{sys.byteorder[0]}e")
+
+
+def _corpus_file_align(offset: int) -> int:
+    return (offset + 63) & ~63
+
+
+def _corpus_file_kind(s: str) -> int:
+    max_char = max(map(ord, s), default=0)
+    if max_char < 0x100:
+        return 0
+    if max_char < 0x10000:
+        return 1
+    return 2
+
+
+def _write_corpus_file(tables: list[list[Any]], processor: str) -> bytearray:
+    count = len(tables[0])
+    processor_data = processor.encode()
+    processor_offset = _CORPUS_FILE_HEADER.size + len(tables) * _CORPUS_FILE_TABLE.size
+    offset = _corpus_file_align(processor_offset + len(processor_data))
+    layouts = []
+    for strings in tables:
+        entries = []
+        segments: list[list[bytes]] = [[], [], []]
+        lengths = [0, 0, 0]
+        for s in strings:
+            if _is_none(s):
+                entries.append((0, 0, _CORPUS_FILE_NONE))
+                continue
+            if not isinstance(s, str):
+                msg = "only strings can be stored in a corpus file"
+                raise ValueError(msg)
+
+            kind = _corpus_file_kind(s)
+            entries.append((lengths[kind], len(s), kind))
+            segments[kind].append(s.encode(_CORPUS_FILE_ENCODINGS[kind], "surrogatepass"))
+            lengths[kind] += len(s)
+
+        entries_offset = offset
+        offset = _corpus_file_align(offset + count * _CORPUS_FILE_ENTRY.size)
+        segment_offsets = []
+        for kind in range(3):
+            segment_offsets.append(offset)
+            offset = _corpus_file_align(offset + (lengths[kind] << kind))
+
+        layouts.append((entries_offset, segment_offsets, lengths, entries, segments))
+
+    data = bytearray(offset)
+    _CORPUS_FILE_HEADER.pack_into(
+        data,
+        0,
+        _CORPUS_FILE_MAGIC,
+        _CORPUS_FILE_VERSION,
+        _CORPUS_FILE_BYTE_ORDER,
+        count,
+        len(tables),
+        processor_offset,
+        len(processor_data),
+    )
+    data[processor_offset : processor_offset + len(processor_data)] = processor_data
+    for i, (entries_offset, segment_offsets, lengths, entries, segments) in enumerate(layouts):
+        _CORPUS_FILE_TABLE.pack_into(
+            data, _CORPUS_FILE_HEADER.size + i * _CORPUS_FILE_TABLE.size, entries_offset, *segment_offsets, *lengths
+        )
+        for j, (pos, length, kind) in enumerate(entries):
+            _CORPUS_FILE_ENTRY.pack_into(data, entries_offset + j * _CORPUS_FILE_ENTRY.size, pos, length, kind, 0)
+        for kind in range(3):
+            segment = b"".join(segments[kind])
+            data[segment_offsets[kind] : segment_offsets[kind] + len(segment)] = segment
+
+    return data
+
+
+def _read_corpus_file(data: bytes) -> tuple[list[list[str | None]], str]:
+    if len(data) < _CORPUS_FILE_HEADER.size:
+        msg = "corpus file is truncated"
+        raise ValueError(msg)
+
+    magic, version, byte_order, count, table_count, processor_offset, processor_length = (
+        _CORPUS_FILE_HEADER.unpack_from(data, 0)
+    )
+    if magic != _CORPUS_FILE_MAGIC:
+        msg = "file is not a corpus file"
+        raise ValueError(msg)
+    if version != _CORPUS_FILE_VERSION:
+        msg = "unsupported corpus file version"
+        raise ValueError(msg)
+    if byte_order != _CORPUS_FILE_BYTE_ORDER:
+        msg = "corpus file was written on a machine with a different byte order"
+        raise ValueError(msg)
+    if table_count not in (1, 2) or (table_count == 2) != (processor_length != 0):
+        msg = "corpus file is corrupted"
+        raise ValueError(msg)
+    if processor_offset + processor_length > len(data):
+        msg = "corpus file is truncated"
+        raise ValueError(msg)
+    processor = bytes(data[processor_offset : processor_offset + processor_length]).decode()
+
+    tables = []
+    try:
+        for i in range(table_count):
+            entries_offset, *layout = _CORPUS_FILE_TABLE.unpack_from(
+                data, _CORPUS_FILE_HEADER.size + i * _CORPUS_FILE_TABLE.size
+            )
+            segment_offsets, lengths = layout[:3], layout[3:]
+            strings: list[str | None] = []
+            for j in range(count):
+                pos, length, kind, _ = _CORPUS_FILE_ENTRY.unpack_from(data, entries_offset + j * _CORPUS_FILE_ENTRY.size)
+                if kind == _CORPUS_FILE_NONE:
+                    strings.append(None)
+                    continue
+                if kind > 2 or pos + length > lengths[kind]:
+                    msg = "corpus file is corrupted"
+                    raise ValueError(msg)
+
+                begin = segment_offsets[kind] + (pos << kind)
+                end = begin + (length << kind)
+                if end > len(data):
+                    msg = "corpus file is truncated"
+                    raise ValueError(msg)
+                strings.append(bytes(data[begin:end]).decode(_CORPUS_FILE_ENCODINGS[kind], "surrogatepass"))
+            tables.append(strings)
+    except struct.error:
+        msg = "corpus file is truncated"
+        raise ValueError(msg) from None
+
+    return tables, processor
+
+
+def _iter_choices(
+    choices: Iterable[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None] | Corpus,
+    processor: Callable[..., Sequence[Hashable]] | None,
+) -> Iterable[tuple[Any, Sequence[Hashable], Sequence[Hashable]]]:
+    """
+    yields (key, choice, processed choice) for all choices, which are not None
+    """
+    if isinstance(choices, Corpus):
+        keys = range(len(choices)) if choices.keys is None else choices.keys
+        for key, choice, proc_choice in zip(keys, choices.choices, choices._proc_choices):
+            if not _is_none(choice):
+                yield (key, choice, proc_choice)  # type: ignore[misc]
+        return
+
+    choices_iter: Iterable[tuple[Any, Sequence[Hashable] | None]]
+    choices_iter = choices.items() if hasattr(choices, "items") else enumerate(choices)  # type: ignore[union-attr]
+    for key, choice in choices_iter:
+        if _is_none(choice):
+            continue
+
+        yield (key, choice, choice if processor is None else processor(choice))  # type: ignore[misc]
+
+
+def _preprocess_list(
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    processor: Callable[..., Sequence[Hashable]] | None,
+) -> list[Sequence[Hashable] | None]:
+    if isinstance(queries, Corpus):
+        return list(queries._proc_choices)
+
+    if processor is None:
+        return list(queries)
+
+    return [x if _is_none(x) else processor(x) for x in queries]
+
+
 @overload
 def extract_iter(
     query: Sequence[Hashable] | None,
@@ -71,7 +428,7 @@ def extract_iter(
 
 def extract_iter(
     query: Sequence[Hashable] | None,
-    choices: Iterable[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None],
+    choices: Iterable[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None] | Corpus,
     *,
     scorer: Callable[..., int | float] = WRatio,
     processor: Callable[..., Sequence[Hashable]] | None = None,
@@ -88,7 +445,8 @@ def extract_iter(
         string we want to find
     choices : Iterable[Sequence[Hashable]] | Mapping[Sequence[Hashable]]
         list of all strings the query should be compared with or dict with a mapping
-        {<result>: <string to compare>}
+        {<result>: <string to compare>}. A Corpus can be passed to reuse the
+        preprocessing of the choices between multiple calls.
     scorer : Callable, optional
         Optional callable that is used to calculate the matching score between
         the query and each choice. This can be any of the scorers included in RapidFuzz
@@ -151,21 +509,8 @@ def extract_iter(
     if processor is not None:
         query = processor(query)
 
-    choices_iter: Iterable[tuple[Any, Sequence[Hashable] | None]]
-    choices_iter = choices.items() if hasattr(choices, "items") else enumerate(choices)  # type: ignore[union-attr]
-    for key, choice in choices_iter:
-        if _is_none(choice):
-            continue
-
-        if processor is None:
-            score = scorer(query, choice, score_cutoff=score_cutoff, **scorer_kwargs)
-        else:
-            score = scorer(
-                query,
-                processor(choice),
-                score_cutoff=score_cutoff,
-                **scorer_kwargs,
-            )
+    for key, choice, proc_choice in _iter_choices(choices, processor):
+        score = scorer(query, proc_choice, score_cutoff=score_cutoff, **scorer_kwargs)
 
         if lowest_score_worst:
             if score >= score_cutoff:
@@ -184,6 +529,7 @@ def extractOne(
     processor: Callable[..., Sequence[Hashable]] | None = None,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[Sequence[Hashable], int | float, int] | None:
     ...
@@ -198,6 +544,7 @@ def extractOne(
     processor: Callable[..., Sequence[Hashable]] | None = None,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[Sequence[Hashable], int | float, Any] | None:
     ...
@@ -205,12 +552,13 @@ def extractOne(
 
 def extractOne(
     query: Sequence[Hashable] | None,
-    choices: Iterable[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None],
+    choices: Iterable[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None] | Corpus,
     *,
     scorer: Callable[..., int | float] = WRatio,
     processor: Callable[..., Sequence[Hashable]] | None = None,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> tuple[Sequence[Hashable], int | float, Any] | None:
     """
@@ -223,7 +571,8 @@ def extractOne(
         string we want to find
     choices : Iterable[Sequence[Hashable]] | Mapping[Sequence[Hashable]]
         list of all strings the query should be compared with or dict with a mapping
-        {<result>: <string to compare>}
+        {<result>: <string to compare>}. A Corpus can be passed to reuse the
+        preprocessing of the choices between multiple calls.
     scorer : Callable, optional
         Optional callable that is used to calculate the matching score between
         the query and each choice. This can be any of the scorers included in RapidFuzz
@@ -242,6 +591,11 @@ def extractOne(
         Optional argument for an expected score to be passed to the scorer.
         This is used to select a faster implementation. Default is None,
         which deactivates this behaviour.
+    workers : int, optional
+        The choices are subdivided into workers sections and evaluated in parallel.
+        Supply -1 to use all available CPU cores.
+        This argument is only available for scorers using the RapidFuzz C-API so far, since it
+        releases the Python GIL.
     scorer_kwargs : dict[str, Any], optional
         any other named parameters are passed to the scorer. This can be used to pass
         e.g. weights to `Levenshtein.distance`
@@ -329,7 +683,7 @@ def extractOne(
     None
 
     """
-    _ = score_hint
+    _ = score_hint, workers
     scorer_kwargs = scorer_kwargs or {}
     worst_score, optimal_score = _get_scorer_flags_py(scorer, scorer_kwargs)
     lowest_score_worst = optimal_score > worst_score
@@ -346,21 +700,8 @@ def extractOne(
 
     result: tuple[Sequence[Hashable], int | float, Any] | None = None
 
-    choices_iter: Iterable[tuple[Any, Sequence[Hashable] | None]]
-    choices_iter = choices.items() if hasattr(choices, "items") else enumerate(choices)  # type: ignore[union-attr]
-    for key, choice in choices_iter:
-        if _is_none(choice):
-            continue
-
-        if processor is None:
-            score = scorer(query, choice, score_cutoff=score_cutoff, **scorer_kwargs)
-        else:
-            score = scorer(
-                query,
-                processor(choice),
-                score_cutoff=score_cutoff,
-                **scorer_kwargs,
-            )
+    for key, choice, proc_choice in _iter_choices(choices, processor):
+        score = scorer(query, proc_choice, score_cutoff=score_cutoff, **scorer_kwargs)
 
         if lowest_score_worst:
             if score >= score_cutoff and (result is None or score > result[1]):
@@ -387,6 +728,7 @@ def extract(
     limit: int | None = 5,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[Sequence[Hashable], int | float, int]]:
     ...
@@ -402,6 +744,7 @@ def extract(
     limit: int | None = 5,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[Sequence[Hashable], int | float, Any]]:
     ...
@@ -409,13 +752,14 @@ def extract(
 
 def extract(
     query: Sequence[Hashable] | None,
-    choices: Collection[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None],
+    choices: Collection[Sequence[Hashable] | None] | Mapping[Any, Sequence[Hashable] | None] | Corpus,
     *,
     scorer: Callable[..., int | float] = WRatio,
     processor: Callable[..., Sequence[Hashable]] | None = None,
     limit: int | None = 5,
     score_cutoff: int | float | None = None,
     score_hint: int | float | None = None,
+    workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
 ) -> list[tuple[Sequence[Hashable], int | float, Any]]:
     """
@@ -428,7 +772,8 @@ def extract(
         string we want to find
     choices : Collection[Sequence[Hashable]] | Mapping[Sequence[Hashable]]
         list of all strings the query should be compared with or dict with a mapping
-        {<result>: <string to compare>}
+        {<result>: <string to compare>}. A Corpus can be passed to reuse the
+        preprocessing of the choices between multiple calls.
     scorer : Callable, optional
         Optional callable that is used to calculate the matching score between
         the query and each choice. This can be any of the scorers included in RapidFuzz
@@ -450,6 +795,11 @@ def extract(
         Optional argument for an expected score to be passed to the scorer.
         This is used to select a faster implementation. Default is None,
         which deactivates this behaviour.
+    workers : int, optional
+        The choices are subdivided into workers sections and evaluated in parallel.
+        Supply -1 to use all available CPU cores.
+        This argument is only available for scorers using the RapidFuzz C-API so far, since it
+        releases the Python GIL.
     scorer_kwargs : dict[str, Any], optional
         any other named parameters are passed to the scorer. This can be used to pass
         e.g. weights to `Levenshtein.distance`
@@ -482,6 +832,7 @@ def extract(
         has the `highest similarity`/`smallest distance`.
 
     """
+    _ = workers
     scorer_kwargs = scorer_kwargs or {}
     worst_score, optimal_score = _get_scorer_flags_py(scorer, scorer_kwargs)
     lowest_score_worst = optimal_score > worst_score
@@ -528,6 +879,33 @@ def _dtype_to_type_num(
     return np.float32
 
 
+def _score_converter(
+    scorer: Callable[..., int | float],
+    scorer_kwargs: dict[str, Any],
+    dtype: np.dtype,
+) -> Callable[[Any], Any]:
+    """
+    scores of floating point scorers are stored as 0-100 in uint8 matrices
+    """
+    import numpy as np
+
+    if np.dtype(dtype) != np.uint8:
+        return lambda score: score
+
+    scale = 1.0
+    params = getattr(scorer, "_RF_ScorerPy", None)
+    if params is not None:
+        flags = params["get_scorer_flags"](**scorer_kwargs)
+        if flags["flags"] & ScorerFlag.RESULT_I64:
+            return lambda score: score
+
+        max_score = max(flags["optimal_score"], flags["worst_score"])
+        if max_score > 0:
+            scale = 100 / max_score
+
+    return lambda score: floor(score * scale + 0.5)
+
+
 def _is_symmetric(scorer: Callable[..., int | float], scorer_kwargs: dict[str, Any]) -> bool:
     params = getattr(scorer, "_RF_ScorerPy", None)
     if params is not None:
@@ -539,8 +917,8 @@ def _is_symmetric(scorer: Callable[..., int | float], scorer_kwargs: dict[str, A
 
 
 def cdist(
-    queries: Collection[Sequence[Hashable] | None],
-    choices: Collection[Sequence[Hashable] | None],
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
     *,
     scorer: Callable[..., int | float] = ratio,
     processor: Callable[..., Sequence[Hashable]] | None = None,
@@ -549,6 +927,7 @@ def cdist(
     dtype: np.dtype | None = None,
     workers: int = 1,
     scorer_kwargs: dict[str, Any] | None = None,
+    out: np.ndarray | None = None,
 ) -> np.ndarray:
     """
     Compute distance/similarity between each pair of the two collections of inputs.
@@ -558,7 +937,8 @@ def cdist(
     queries : Collection[Sequence[Hashable]]
         list of all strings the queries
     choices : Collection[Sequence[Hashable]]
-        list of all strings the query should be compared
+        list of all strings the query should be compared. Both queries and choices
+        can be a Corpus to reuse their preprocessing between multiple calls.
     scorer : Callable, optional
         Optional callable that is used to calculate the matching score between
         the query and each choice. This can be any of the scorers included in RapidFuzz
@@ -594,44 +974,251 @@ def cdist(
     scorer_kwargs : dict[str, Any], optional
         any other named parameters are passed to the scorer. This can be used to pass
         e.g. weights to `Levenshtein.distance`
+    out : ndarray, optional
+        Writable matrix with the shape (len(queries), len(choices)) the results are
+        written into instead of allocating a new one. It can be strided, so e.g. a
+        block of a larger ``np.memmap`` can be filled using
+        ``out=matrix[row:row + len(queries), col:col + len(choices)]``. Its dtype is
+        used when dtype is not given.
 
     Returns
     -------
     ndarray
         Returns a matrix of dtype with the distance/similarity between each pair
-        of the two collections of inputs.
+        of the two collections of inputs. This is out when it is given.
     """
     import numpy as np
 
     _ = workers, score_hint
     scorer_kwargs = scorer_kwargs or {}
+    if out is not None:
+        if dtype is not None and np.dtype(dtype) != out.dtype:
+            msg = "the dtype of out does not match dtype"
+            raise ValueError(msg)
+        if not out.flags.writeable:
+            msg = "out has to be writable"
+            raise ValueError(msg)
+        if out.shape != (len(queries), len(choices)):
+            msg = f"out has to be a matrix with the shape ({len(queries)}, {len(choices)})"
+            raise ValueError(msg)
+        dtype = out.dtype
+
     dtype = _dtype_to_type_num(dtype, scorer, scorer_kwargs)
-    results = np.zeros((len(queries), len(choices)), dtype=dtype)
+    convert = _score_converter(scorer, scorer_kwargs, dtype)
+    results = np.zeros((len(queries), len(choices)), dtype=dtype) if out is None else out
 
-    if processor is None:
-        proc_choices = list(choices)
-    else:
-        proc_choices = [x if _is_none(x) else processor(x) for x in choices]
+    proc_choices = _preprocess_list(choices, processor)
 
     if queries is choices and _is_symmetric(scorer, scorer_kwargs):
         for i, query in enumerate(proc_choices):
-            results[i, i] = scorer(query, query, score_cutoff=score_cutoff, **scorer_kwargs)
+            results[i, i] = convert(scorer(query, query, score_cutoff=score_cutoff, **scorer_kwargs))
             for j in range(i + 1, len(proc_choices)):
-                results[i, j] = results[j, i] = scorer(
-                    query,
-                    proc_choices[j],
-                    score_cutoff=score_cutoff,
-                    **scorer_kwargs,
+                results[i, j] = results[j, i] = convert(
+                    scorer(
+                        query,
+                        proc_choices[j],
+                        score_cutoff=score_cutoff,
+                        **scorer_kwargs,
+                    )
                 )
     else:
-        for i, query in enumerate(queries):
-            proc_query = processor(query) if (processor and not _is_none(query)) else query
+        for i, proc_query in enumerate(_preprocess_list(queries, processor)):
             for j, choice in enumerate(proc_choices):
-                results[i, j] = scorer(
-                    proc_query,
-                    choice,
-                    score_cutoff=score_cutoff,
-                    **scorer_kwargs,
+                results[i, j] = convert(
+                    scorer(
+                        proc_query,
+                        choice,
+                        score_cutoff=score_cutoff,
+                        **scorer_kwargs,
+                    )
                 )
 
     return results
+
+
+def cdist_sparse(
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
+    *,
+    scorer: Callable[..., int | float] = ratio,
+    processor: Callable[..., Sequence[Hashable]] | None = None,
+    score_cutoff: int | float | None = None,
+    score_hint: int | float | None = None,
+    dtype: np.dtype | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
+    """
+    Compute distance/similarity between each pair of the two collections of inputs
+    and only keep the pairs with a score passing the score_cutoff. Unlike `cdist`
+    this never allocates the dense matrix.
+
+    Parameters
+    ----------
+    queries : Collection[Sequence[Hashable]]
+        list of all strings the queries
+    choices : Collection[Sequence[Hashable]]
+        list of all strings the query should be compared. Both queries and choices
+        can be a Corpus to reuse their preprocessing between multiple calls.
+    scorer : Callable, optional
+        Optional callable that is used to calculate the matching score between
+        the query and each choice. fuzz.ratio is used by default.
+    processor : Callable, optional
+        Optional callable that is used to preprocess the strings before
+        comparing them. Default is None, which deactivates this behaviour.
+    score_cutoff : Any, optional
+        Pairs with a similarity below / a distance above this value are not
+        part of the result. Default is None, which keeps all pairs.
+    score_hint : Any, optional
+        Optional argument for an expected score to be passed to the scorer.
+        This is used to select a faster implementation. Default is None,
+        which deactivates this behaviour.
+    dtype : data-type, optional
+        The desired data-type for the scores. The same dtypes as in `cdist` are supported.
+    workers : int, optional
+        The calculation is subdivided into workers sections and evaluated in parallel.
+        Supply -1 to use all available CPU cores.
+        This argument is only available for scorers using the RapidFuzz C-API so far, since it
+        releases the Python GIL.
+    scorer_kwargs : dict[str, Any], optional
+        any other named parameters are passed to the scorer. This can be used to pass
+        e.g. weights to `Levenshtein.distance`
+
+    Returns
+    -------
+    tuple[ndarray, ndarray, ndarray]
+        Returns the tuple (data, indices, indptr) of a matrix in compressed sparse row format.
+        The choices matching the query i and their scores are stored in
+        ``indices[indptr[i]:indptr[i + 1]]`` and ``data[indptr[i]:indptr[i + 1]]`` ordered by
+        their index. The tuple can be passed to ``scipy.sparse.csr_matrix`` directly.
+    """
+    import numpy as np
+
+    _ = workers, score_hint
+    scorer_kwargs = scorer_kwargs or {}
+    dtype = _dtype_to_type_num(dtype, scorer, scorer_kwargs)
+    convert = _score_converter(scorer, scorer_kwargs, dtype)
+    worst_score, optimal_score = _get_scorer_flags_py(scorer, scorer_kwargs)
+    lowest_score_worst = optimal_score > worst_score
+
+    data = []
+    indices = []
+    indptr = [0]
+    proc_choices = _preprocess_list(choices, processor)
+    for proc_query in _preprocess_list(queries, processor):
+        for j, choice in enumerate(proc_choices):
+            score = scorer(proc_query, choice, score_cutoff=score_cutoff, **scorer_kwargs)
+            if score_cutoff is None or (score >= score_cutoff if lowest_score_worst else score <= score_cutoff):
+                data.append(convert(score))
+                indices.append(j)
+
+        indptr.append(len(data))
+
+    return (
+        np.array(data, dtype=dtype),
+        np.array(indices, dtype=np.int64),
+        np.array(indptr, dtype=np.int64),
+    )
+
+
+def cdist_topk(
+    queries: Collection[Sequence[Hashable] | None] | Corpus,
+    choices: Collection[Sequence[Hashable] | None] | Corpus,
+    *,
+    limit: int = 5,
+    scorer: Callable[..., int | float] = ratio,
+    processor: Callable[..., Sequence[Hashable]] | None = None,
+    score_cutoff: int | float | None = None,
+    score_hint: int | float | None = None,
+    dtype: np.dtype | None = None,
+    workers: int = 1,
+    scorer_kwargs: dict[str, Any] | None = None,
+) -> tuple[np.ndarray, np.ndarray]:
+    """
+    Find the best matches in choices for each of the queries. This is equivalent
+    to calling `extract` for each query, but returns the results as two arrays.
+
+    Parameters
+    ----------
+    queries : Collection[Sequence[Hashable]]
+        list of all strings the queries
+    choices : Collection[Sequence[Hashable]]
+        list of all strings the query should be compared. Both queries and choices
+        can be a Corpus to reuse their preprocessing between multiple calls.
+    limit : int
+        maximum amount of results to return per query. Default is 5.
+    scorer : Callable, optional
+        Optional callable that is used to calculate the matching score between
+        the query and each choice. fuzz.ratio is used by default.
+    processor : Callable, optional
+        Optional callable that is used to preprocess the strings before
+        comparing them. Default is None, which deactivates this behaviour.
+    score_cutoff : Any, optional
+        Optional argument for a score threshold. Matches with a similarity below /
+        a distance above this value are not part of the result.
+        Default is None, which deactivates this behaviour.
+    score_hint : Any, optional
+        Optional argument for an expected score to be passed to the scorer.
+        This is used to select a faster implementation. Default is None,
+        which deactivates this behaviour.
+    dtype : data-type, optional
+        The desired data-type for the scores. The same dtypes as in `cdist` are supported.
+    workers : int, optional
+        The calculation is subdivided into workers sections and evaluated in parallel.
+        Supply -1 to use all available CPU cores.
+        This argument is only available for scorers using the RapidFuzz C-API so far, since it
+        releases the Python GIL.
+    scorer_kwargs : dict[str, Any], optional
+        any other named parameters are passed to the scorer. This can be used to pass
+        e.g. weights to `Levenshtein.distance`
+
+    Returns
+    -------
+    tuple[ndarray, ndarray]
+        Returns the tuple (indices, scores). Both have the shape ``(len(queries), limit)``.
+        Row i holds the index and score of the best matches for query i sorted like the
+        results of `extract`. Rows with less than limit matches are padded with the index -1.
+        The scores of these padded elements are the worst score of the scorer clamped to the range
+        of dtype, so e.g. distances are padded with the maximum of an integer dtype.
+    """
+    import numpy as np
+
+    _ = workers, score_hint
+    if limit <= 0:
+        msg = "limit has to be > 0"
+        raise ValueError(msg)
+
+    scorer_kwargs = scorer_kwargs or {}
+    dtype = _dtype_to_type_num(dtype, scorer, scorer_kwargs)
+    worst_score, optimal_score = _get_scorer_flags_py(scorer, scorer_kwargs)
+    lowest_score_worst = optimal_score > worst_score
+
+    proc_queries = _preprocess_list(queries, processor)
+    proc_choices = _preprocess_list(choices, processor)
+    indices = np.full((len(proc_queries), limit), -1, dtype=np.int64)
+    # the worst score is clamped to the range of integer dtypes, so the unbounded worst score
+    # of distances stays the worst score
+    convert = _score_converter(scorer, scorer_kwargs, dtype)
+    pad_score = convert(worst_score)
+    if np.issubdtype(dtype, np.integer):
+        pad_score = min(max(pad_score, np.iinfo(dtype).min), np.iinfo(dtype).max)
+    scores = np.full((len(proc_queries), limit), pad_score, dtype=dtype)
+
+    for i, proc_query in enumerate(proc_queries):
+        if _is_none(proc_query):
+            continue
+
+        matches = []
+        for j, choice in enumerate(proc_choices):
+            if _is_none(choice):
+                continue
+
+            score = scorer(proc_query, choice, score_cutoff=score_cutoff, **scorer_kwargs)
+            if score_cutoff is None or (score >= score_cutoff if lowest_score_worst else score <= score_cutoff):
+                matches.append((-score if lowest_score_worst else score, j, score))
+
+        for k, (_, j, score) in enumerate(heapq.nsmallest(limit, matches)):
+            indices[i, k] = j
+            scores[i, k] = convert(score)
+
+    return (indices, scores)
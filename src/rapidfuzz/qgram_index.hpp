@@ -0,0 +1,243 @@
+#pragma once
+#include "cpp_common.hpp"
+#include "rapidfuzz.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Inverted index of process.Corpus mapping each q-gram to the strings containing it.
+ *
+ * The posting list of a q-gram stores the index of each string containing it in ascending order.
+ * The indices are delta encoded as varints with the lowest bit set, when the q-gram occurs more
+ * than once in the string. In this case the number of occurrences follows as a second varint.
+ *
+ * The q-grams are stored as hash of their characters. Collisions merge posting lists, which
+ * can only increase the number of q-grams a string appears to share with the query.
+ */
+
+static inline uint64_t qgram_hash(uint64_t hash, uint64_t ch)
+{
+    return (hash ^ ch) * 0x100000001B3ULL;
+}
+
+/**
+ * @brief q-grams of a string with the number of their occurrences sorted by their hash
+ */
+static inline std::vector<std::pair<uint64_t, uint32_t>> count_qgrams(const RF_String& str, size_t q)
+{
+    std::vector<uint64_t> grams;
+    visit(str, [&](auto s) {
+        size_t len = static_cast<size_t>(s.size());
+        if (len < q) return;
+
+        grams.reserve(len - q + 1);
+        auto first = s.begin();
+        for (size_t i = 0; i + q <= len; ++i) {
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (size_t k = 0; k < q; ++k)
+                hash = qgram_hash(hash, static_cast<uint64_t>(first[static_cast<ptrdiff_t>(i + k)]));
+            grams.push_back(hash);
+        }
+    });
+    std::sort(grams.begin(), grams.end());
+
+    std::vector<std::pair<uint64_t, uint32_t>> counts;
+    for (uint64_t gram : grams) {
+        if (!counts.empty() && counts.back().first == gram)
+            ++counts.back().second;
+        else
+            counts.emplace_back(gram, 1);
+    }
+    return counts;
+}
+
+static inline void varint_encode(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static inline uint64_t varint_decode(const uint8_t*& pos)
+{
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+class QGramIndex {
+public:
+    /* the number of shared q-grams, which marks all strings of a length as candidates */
+    static constexpr int64_t all_candidates = 0;
+    /* the number of shared q-grams, which skips all strings of a length */
+    static constexpr int64_t no_candidates = std::numeric_limits<int64_t>::max();
+
+    QGramIndex() : m_q(0)
+    {}
+
+    /**
+     * @brief indexes the q-grams of `strings`. None is not indexed
+     */
+    void build(const std::vector<RF_StringWrapper>& strings, size_t q)
+    {
+        if (q == 0) throw std::invalid_argument("q-grams require a length of at least 1");
+
+        m_q = q;
+        m_postings.clear();
+
+        /* group the strings by length, so all strings of a length can be retrieved without
+         * using the posting lists */
+        std::vector<std::pair<size_t, int64_t>> by_length;
+        by_length.reserve(strings.size());
+        for (size_t i = 0; i < strings.size(); ++i)
+            if (!strings[i].is_none()) by_length.emplace_back(strings[i].size(), static_cast<int64_t>(i));
+        std::sort(by_length.begin(), by_length.end());
+
+        m_lengths.clear();
+        m_length_offsets.clear();
+        m_length_choices.clear();
+        m_length_choices.reserve(by_length.size());
+        m_length_ids.assign(strings.size(), 0);
+        for (const auto& elem : by_length) {
+            if (m_lengths.empty() || m_lengths.back() != elem.first) {
+                m_lengths.push_back(elem.first);
+                m_length_offsets.push_back(m_length_choices.size());
+            }
+            m_length_ids[static_cast<size_t>(elem.second)] = static_cast<uint32_t>(m_lengths.size() - 1);
+            m_length_choices.push_back(elem.second);
+        }
+        m_length_offsets.push_back(m_length_choices.size());
+
+        for (size_t i = 0; i < strings.size(); ++i) {
+            if (strings[i].is_none()) continue;
+
+            for (const auto& gram : count_qgrams(strings[i].string, q)) {
+                PostingList& list = m_postings[gram.first];
+                uint64_t delta = static_cast<uint64_t>(static_cast<int64_t>(i) - list.last_index);
+                varint_encode(list.data, (delta << 1) | (gram.second > 1));
+                if (gram.second > 1) varint_encode(list.data, gram.second);
+                list.last_index = static_cast<int64_t>(i);
+            }
+        }
+
+        for (auto& posting : m_postings)
+            posting.second.data.shrink_to_fit();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_q == 0;
+    }
+
+    size_t qgram_size() const noexcept
+    {
+        return m_q;
+    }
+
+    /**
+     * @brief distinct lengths of the indexed strings in ascending order
+     */
+    const std::vector<size_t>& lengths() const noexcept
+    {
+        return m_lengths;
+    }
+
+    /**
+     * @brief indices of all strings sharing at least `min_shared[i]` q-grams with `query`, where
+     * i is the position of their length in lengths(). The indices are returned in ascending order.
+     */
+    std::vector<int64_t> candidates(const RF_String& query, const std::vector<int64_t>& min_shared) const
+    {
+        if (min_shared.size() != m_lengths.size())
+            throw std::invalid_argument("min_shared requires one element per length");
+
+        std::vector<int64_t> res;
+        for (size_t i = 0; i < m_lengths.size(); ++i) {
+            if (min_shared[i] > all_candidates) continue;
+            res.insert(res.end(), m_length_choices.begin() + static_cast<ptrdiff_t>(m_length_offsets[i]),
+                       m_length_choices.begin() + static_cast<ptrdiff_t>(m_length_offsets[i + 1]));
+        }
+
+        /* merge the posting lists of all q-grams of the query counting the shared q-grams */
+        std::vector<PostingCursor> cursors;
+        for (const auto& gram : count_qgrams(query, m_q)) {
+            auto posting = m_postings.find(gram.first);
+            if (posting == m_postings.end()) continue;
+
+            PostingCursor cursor = {posting->second.data.data(),
+                                    posting->second.data.data() + posting->second.data.size(), -1, 0,
+                                    gram.second};
+            cursor.next();
+            cursors.push_back(cursor);
+        }
+
+        using HeapElem = std::pair<int64_t, size_t>;
+        std::priority_queue<HeapElem, std::vector<HeapElem>, std::greater<HeapElem>> heap;
+        for (size_t i = 0; i < cursors.size(); ++i)
+            heap.emplace(cursors[i].index, i);
+
+        while (!heap.empty()) {
+            int64_t index = heap.top().first;
+            int64_t shared = 0;
+            while (!heap.empty() && heap.top().first == index) {
+                PostingCursor& cursor = cursors[heap.top().second];
+                shared += std::min(cursor.count, cursor.query_count);
+                heap.pop();
+                if (cursor.next()) heap.emplace(cursor.index, static_cast<size_t>(&cursor - cursors.data()));
+            }
+
+            int64_t required = min_shared[m_length_ids[static_cast<size_t>(index)]];
+            if (required > all_candidates && shared >= required) res.push_back(index);
+        }
+
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+private:
+    struct PostingList {
+        std::vector<uint8_t> data;
+        int64_t last_index = -1;
+    };
+
+    struct PostingCursor {
+        const uint8_t* pos;
+        const uint8_t* end;
+        int64_t index;
+        uint32_t count;
+        uint32_t query_count;
+
+        bool next()
+        {
+            if (pos == end) return false;
+
+            uint64_t value = varint_decode(pos);
+            index += static_cast<int64_t>(value >> 1);
+            count = (value & 1) ? static_cast<uint32_t>(varint_decode(pos)) : 1;
+            return true;
+        }
+    };
+
+    size_t m_q;
+    std::unordered_map<uint64_t, PostingList> m_postings;
+    std::vector<size_t> m_lengths;
+    /* strings grouped by length. Those of m_lengths[i] are stored in
+     * m_length_choices[m_length_offsets[i], m_length_offsets[i + 1]) */
+    std::vector<size_t> m_length_offsets;
+    std::vector<int64_t> m_length_choices;
+    /* position of the length of each string in m_lengths */
+    std::vector<uint32_t> m_length_ids;
+};
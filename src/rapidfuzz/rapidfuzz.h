@@ -120,6 +120,30 @@ typedef struct _RF_ScorerFunc {
 
     /* members */
     void* context; /**< context of the scorer */
+
+    /**
+     * @brief Calculate edit distance with many strings in a single call. Each of the strings is
+     * compared with the `strings` passed into `ctor` as if `call` was used for each of them.
+     *
+     * @note added in version 3 of RF_Scorer. Can be NULL, in which case `call` has to be used.
+     * Uses the same result type as `call`.
+     *
+     * @param[in] self pointer to RF_ScorerFunc instance
+     * @param[in] str array of `str_count` strings to calculate the distance with
+     * @param[in] str_count size of the `str` array
+     * @param[in] score_cutoffs array of `str_count` score thresholds, one for each string
+     * @param[in] score_hint argument for an expected score to improve the performance
+     * @param[out] result array for the results of the calculation. The results of `str[i]` are
+     *                    stored at `result + i * n`, where n is the number of results `call` produces
+     *
+     * @return true on success and false with a Python exception set on failure
+     */
+    union {
+        bool (*f64)(const struct _RF_ScorerFunc* self, const RF_String* str, int64_t str_count,
+                    const double* score_cutoffs, double score_hint, double* result);
+        bool (*i64)(const struct _RF_ScorerFunc* self, const RF_String* str, int64_t str_count,
+                    const int64_t* score_cutoffs, int64_t score_hint, int64_t* result);
+    } call_batch;
 } RF_ScorerFunc;
 
 /**
@@ -163,6 +187,27 @@ typedef bool (*RF_ScorerFuncInit)(RF_ScorerFunc* self, const RF_Kwargs* kwargs,
 /* when none is passed this is the worst score */
 #define RF_SCORER_NONE_IS_WORST_SCORE ((uint32_t)1 << 13)
 
+/* the best score any string of length n can achieve is reached by the first n characters of the
+ * string passed into RF_ScorerFuncInit, or by this string padded to a length of n with arbitrary
+ * characters. E.g. the Levenshtein distance is at least the length difference of the strings.
+ * This bound must not improve as n moves further away from the length of the string. This allows
+ * skipping all strings of a length and all lengths further away, which can not reach the score_cutoff
+ */
+#define RF_SCORER_FLAG_LENGTH_BOUND ((uint32_t)1 << 14)
+
+/* for a string of length n the best score with a longest common subsequence of length L with the
+ * string passed into RF_ScorerFuncInit is reached by its first n characters with all but L of them
+ * replaced by characters it does not contain, padded to a length of n with such characters. The score
+ * gets worse with each replaced character. This holds for edit distances like Levenshtein or Indel
+ * and allows bounding the number of q-grams a string shares with it based on the score_cutoff
+ */
+#define RF_SCORER_FLAG_LCS_BOUND ((uint32_t)1 << 15)
+
+/* RF_ScorerFuncInit with str_count != 1 supports strings longer than 64 characters.
+ * Only valid in combination with RF_SCORER_FLAG_MULTI_STRING_INIT
+ */
+#define RF_SCORER_FLAG_MULTI_STRING_LONG ((uint32_t)1 << 16)
+
 /**
  * @brief information associated with a scorer
  */
@@ -202,7 +247,8 @@ typedef bool (*RF_GetScorerFlags)(const RF_Kwargs* kwargs, RF_ScorerFlags* score
  * @brief struct describing a Scorer callback function.
  */
 typedef struct {
-#define SCORER_STRUCT_VERSION ((uint32_t)2)
+/* version 3 added RF_ScorerFunc::call_batch */
+#define SCORER_STRUCT_VERSION ((uint32_t)3)
     uint32_t version;                   /**< version number of the structure. Set to SCORER_STRUCT_VERSION */
     RF_KwargsInit kwargs_init;          /**< keyword argument constructor */
     RF_GetScorerFlags get_scorer_flags; /**< function to retrieve additional information about the scorer */
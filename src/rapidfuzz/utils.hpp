@@ -11,25 +11,20 @@
 #include <limits>
 #include <stdint.h>
 #include <string>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define RAPIDFUZZ_DEFAULT_PROCESS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define RAPIDFUZZ_DEFAULT_PROCESS_SSE2
+#endif
 
 uint32_t UnicodeDefaultProcess(uint32_t ch);
 
-/**
- * @brief removes any non alphanumeric characters, trim whitespaces from
- * beginning/end and lowercase the string. Currently this only supports
- * Ascii. Characters outside of the ascii spec are not changed. This
- * will be changed in the future to support full unicode. In case this has
- * has a noticeable effect on the performance an additional `ascii_default_process`
- * function will be provided, that keeps this behaviour
- *
- * @tparam CharT char type of the string
- *
- * @param s string to process
- *
- * @return returns the processed string
- */
 template <typename CharT>
-int64_t default_process(CharT* str, int64_t len)
+static inline CharT default_process_char(CharT ch)
 {
     /* mapping converting
      * - non alphanumeric characters to whitespace (32)
@@ -54,26 +49,212 @@ int64_t default_process(CharT* str, int64_t len)
         252, 253, 254, 223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239,
         240, 241, 242, 243, 244, 245, 246, 32,  248, 249, 250, 251, 252, 253, 254, 255};
 
-    std::transform(str, str + len, str, [](CharT ch) {
-        /* irrelevant cases for a given char type are removed at compile time by any decent compiler
-         */
-        if (ch < 0 || ch > std::numeric_limits<uint32_t>::max())
-            return ch;
-        else if (ch < 256)
-            return static_cast<CharT>(extended_ascii_mapping[ch]);
+    /* irrelevant cases for a given char type are removed at compile time by any decent compiler
+     */
+    if (ch < 0 || ch > std::numeric_limits<uint32_t>::max())
+        return ch;
+    else if (ch < 256)
+        return static_cast<CharT>(extended_ascii_mapping[ch]);
+    else
+        return static_cast<CharT>(UnicodeDefaultProcess(static_cast<uint32_t>(ch)));
+}
+
+#if defined(RAPIDFUZZ_DEFAULT_PROCESS_AVX2) || defined(RAPIDFUZZ_DEFAULT_PROCESS_SSE2)
+/**
+ * @brief vector operations used by default_process on strings with the char type CharT,
+ * which is either uint8_t or uint16_t. The vector width is selected by the compiler flags
+ * of the module, which is picked at runtime by `vectorized_import`
+ */
+template <typename CharT>
+struct DefaultProcessSimd {
+#    ifdef RAPIDFUZZ_DEFAULT_PROCESS_AVX2
+    using reg = __m256i;
+    static constexpr uint32_t all_lanes = 0xFFFFFFFF;
+
+    static reg load(const CharT* str)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str));
+    }
+
+    static void store(CharT* str, reg a)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(str), a);
+    }
+
+    static reg splat(CharT ch)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm256_set1_epi8(static_cast<char>(ch));
         else
-            return static_cast<CharT>(UnicodeDefaultProcess(static_cast<uint32_t>(ch)));
-    });
+            return _mm256_set1_epi16(static_cast<short>(ch));
+    }
 
-    while (len > 0 && str[len - 1] == ' ')
-        len--;
+    static reg eq(reg a, reg b)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm256_cmpeq_epi8(a, b);
+        else
+            return _mm256_cmpeq_epi16(a, b);
+    }
+
+    /* signed comparison, so it is only valid for ascii characters */
+    static reg gt(reg a, reg b)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm256_cmpgt_epi8(a, b);
+        else
+            return _mm256_cmpgt_epi16(a, b);
+    }
+
+    static reg bit_and(reg a, reg b)
+    {
+        return _mm256_and_si256(a, b);
+    }
+
+    static reg bit_or(reg a, reg b)
+    {
+        return _mm256_or_si256(a, b);
+    }
+
+    static uint32_t movemask(reg a)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(a));
+    }
+#    else
+    using reg = __m128i;
+    static constexpr uint32_t all_lanes = 0xFFFF;
+
+    static reg load(const CharT* str)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+    }
+
+    static void store(CharT* str, reg a)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(str), a);
+    }
+
+    static reg splat(CharT ch)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm_set1_epi8(static_cast<char>(ch));
+        else
+            return _mm_set1_epi16(static_cast<short>(ch));
+    }
+
+    static reg eq(reg a, reg b)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm_cmpeq_epi8(a, b);
+        else
+            return _mm_cmpeq_epi16(a, b);
+    }
+
+    /* signed comparison, so it is only valid for ascii characters */
+    static reg gt(reg a, reg b)
+    {
+        if constexpr (sizeof(CharT) == 1)
+            return _mm_cmpgt_epi8(a, b);
+        else
+            return _mm_cmpgt_epi16(a, b);
+    }
+
+    static reg bit_and(reg a, reg b)
+    {
+        return _mm_and_si128(a, b);
+    }
+
+    static reg bit_or(reg a, reg b)
+    {
+        return _mm_or_si128(a, b);
+    }
+
+    static uint32_t movemask(reg a)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(a));
+    }
+#    endif
+
+    static constexpr int64_t lanes = static_cast<int64_t>(sizeof(reg) / sizeof(CharT));
+
+    static bool all_spaces(const CharT* str)
+    {
+        return movemask(eq(load(str), splat(' '))) == all_lanes;
+    }
+
+    /**
+     * @brief applies default_process_char to a block of `lanes` characters. Blocks including
+     * characters outside of ascii are not modified and false is returned
+     */
+    static bool process_ascii_block(CharT* str)
+    {
+        reg ch = load(str);
+        if (movemask(eq(bit_and(ch, splat(static_cast<CharT>(~0x7F))), splat(0))) != all_lanes) return false;
+
+        /* setting 0x20 maps uppercase letters to lowercase without moving any other character
+         * into the range of letters */
+        reg lower = bit_or(ch, splat(0x20));
+        reg is_alpha = bit_and(gt(lower, splat('a' - 1)), gt(splat('z' + 1), lower));
+        reg is_digit = bit_and(gt(ch, splat('0' - 1)), gt(splat('9' + 1), ch));
+        reg is_other = eq(bit_or(is_alpha, is_digit), splat(0));
+
+        reg alnum = bit_or(bit_and(is_alpha, lower), bit_and(is_digit, ch));
+        store(str, bit_or(alnum, bit_and(is_other, splat(' '))));
+        return true;
+    }
+};
+#endif
+
+/**
+ * @brief removes any non alphanumeric characters, trim whitespaces from
+ * beginning/end and lowercase the string. Currently this only supports
+ * Ascii. Characters outside of the ascii spec are not changed. This
+ * will be changed in the future to support full unicode. In case this has
+ * has a noticeable effect on the performance an additional `ascii_default_process`
+ * function will be provided, that keeps this behaviour
+ *
+ * Latin-1 and UCS-2 strings are processed in blocks using SSE2/AVX2. Only blocks
+ * including characters outside of ascii fall back to the lookup per character.
+ *
+ * @tparam CharT char type of the string
+ *
+ * @param s string to process
+ *
+ * @return returns the processed string
+ */
+template <typename CharT>
+int64_t default_process(CharT* str, int64_t len)
+{
+    int64_t pos = 0;
+#if defined(RAPIDFUZZ_DEFAULT_PROCESS_AVX2) || defined(RAPIDFUZZ_DEFAULT_PROCESS_SSE2)
+    if constexpr (std::is_same<CharT, uint8_t>::value || std::is_same<CharT, uint16_t>::value) {
+        using simd = DefaultProcessSimd<CharT>;
+        for (; pos + simd::lanes <= len; pos += simd::lanes)
+            if (!simd::process_ascii_block(str + pos))
+                std::transform(str + pos, str + pos + simd::lanes, str + pos, default_process_char<CharT>);
+    }
+#endif
+    std::transform(str + pos, str + len, str + pos, default_process_char<CharT>);
 
     int64_t prefix = 0;
-    while (len > 0 && str[prefix] == ' ') {
+#if defined(RAPIDFUZZ_DEFAULT_PROCESS_AVX2) || defined(RAPIDFUZZ_DEFAULT_PROCESS_SSE2)
+    /* whole blocks of whitespaces are skipped using simd and the remaining ones below */
+    if constexpr (std::is_same<CharT, uint8_t>::value || std::is_same<CharT, uint16_t>::value) {
+        using simd = DefaultProcessSimd<CharT>;
+        while (len >= simd::lanes && simd::all_spaces(str + len - simd::lanes))
+            len -= simd::lanes;
+        while (len - prefix >= simd::lanes && simd::all_spaces(str + prefix))
+            prefix += simd::lanes;
+    }
+#endif
+
+    while (len > prefix && str[len - 1] == ' ')
         len--;
+
+    while (len > prefix && str[prefix] == ' ')
         prefix++;
-    }
 
+    len -= prefix;
     if (prefix != 0) std::copy(str + prefix, str + prefix + len, str);
 
     return len;
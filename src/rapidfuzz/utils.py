@@ -5,6 +5,7 @@ from __future__ import annotations
 
 from rapidfuzz._utils import fallback_import as _fallback_import
 
-__all__ = ["default_process"]
+__all__ = ["default_process", "default_process_list"]
 
 default_process = _fallback_import("rapidfuzz.utils", "default_process")
+default_process_list = _fallback_import("rapidfuzz.utils", "default_process_list")
@@ -6,3 +6,4 @@ from __future__ import annotations
 from typing import Hashable, Sequence
 
 def default_process(sentence: Sequence[Hashable]) -> Sequence[Hashable]: ...
+def default_process_list(sentences: Sequence[str], *, workers: int = 1) -> list[str]: ...
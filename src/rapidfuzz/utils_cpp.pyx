@@ -3,6 +3,7 @@
 
 from cpp_common cimport (
     CreateProcessorContext,
+    SetFuncAttrs,
     SetProcessorAttrs,
     conv_sequence,
     convert_string,
@@ -29,6 +30,12 @@ def default_process(sentence):
     return default_process_impl(sentence)
 
 
+def default_process_list(sentences, *, int workers=1):
+    # the strings are processed by the thread pool of the process module without holding the GIL
+    from rapidfuzz._utils import vectorized_import
+    return vectorized_import("rapidfuzz.process_cpp_impl").default_process_list(sentences, workers=workers)
+
+
 cdef bool default_process_capi(sentence, RF_String* str_) except False:
     validate_string(sentence, "sentence must be a String")
     proc_str = conv_sequence(sentence)
@@ -44,3 +51,4 @@ cdef bool default_process_capi(sentence, RF_String* str_) except False:
 
 cdef RF_Preprocessor DefaultProcessContext = CreateProcessorContext(default_process_capi)
 SetProcessorAttrs(default_process, utils_py.default_process, &DefaultProcessContext)
+SetFuncAttrs(default_process_list, utils_py.default_process_list)
@@ -4,6 +4,7 @@
 from __future__ import annotations
 
 import re
+from typing import Sequence
 
 _alnum_regex = re.compile(r"(?ui)\W")
 
@@ -30,3 +31,24 @@ def default_process(sentence: str) -> str:
     """
     string_out = _alnum_regex.sub(" ", sentence)
     return string_out.strip().lower()
+
+
+def default_process_list(sentences: Sequence[str], *, workers: int = 1) -> list[str]:
+    """
+    Applies `default_process` to each string of a sequence
+
+    Parameters
+    ----------
+    sentences : Sequence[str]
+        Strings to preprocess
+    workers : int, optional
+        The calculation is subdivided into workers sections and evaluated in parallel.
+        Using workers=-1 uses all available cores. Default is 1
+
+    Returns
+    -------
+    processed_strings : list[str]
+        processed strings in the order of `sentences`
+    """
+    _ = workers
+    return [default_process(sentence) for sentence in sentences]
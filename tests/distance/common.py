@@ -1,6 +1,6 @@
 from __future__ import annotations
 
-from rapidfuzz._feature_detector import AVX2, supports
+from rapidfuzz._feature_detector import AVX2, AVX512, supports
 from rapidfuzz.distance import metrics_cpp, metrics_py
 from tests.common import GenericScorer, Scorer, is_none
 
@@ -12,6 +12,13 @@ try:
         cpp_scorer_modules.append(metrics_cpp_avx2)
 except Exception:
     pass
+try:
+    if supports(AVX512):
+        from rapidfuzz.distance import metrics_cpp_avx512
+
+        cpp_scorer_modules.append(metrics_cpp_avx512)
+except Exception:
+    pass
 
 
 def create_generic_scorer(func_name, get_scorer_flags):
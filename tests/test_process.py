@@ -1,11 +1,13 @@
 from __future__ import annotations
 
+import itertools
+import os
 from contextlib import suppress
 
 import pytest
 
-from rapidfuzz import fuzz, process_cpp, process_py
-from rapidfuzz.distance import Levenshtein, Levenshtein_py
+from rapidfuzz import fuzz, process_cpp, process_py, utils
+from rapidfuzz.distance import OSA, DamerauLevenshtein, Hamming, Indel, LCSseq, Levenshtein, Levenshtein_py, Prefix
 
 with suppress(BaseException):
     import numpy as np
@@ -55,6 +57,24 @@ class process:
             assert np.array_equal(res1, res2)
         return res1
 
+    @staticmethod
+    def cdist_sparse(*args, **kwargs):
+        res1 = process_cpp.cdist_sparse(*args, **kwargs)
+        res2 = process_py.cdist_sparse(*args, **kwargs)
+        for arr1, arr2 in zip(res1, res2):
+            assert arr1.dtype == arr2.dtype
+            assert np.array_equal(arr1, arr2)
+        return res1
+
+    @staticmethod
+    def cdist_topk(*args, **kwargs):
+        res1 = process_cpp.cdist_topk(*args, **kwargs)
+        res2 = process_py.cdist_topk(*args, **kwargs)
+        for arr1, arr2 in zip(res1, res2):
+            assert arr1.dtype == arr2.dtype
+            assert np.array_equal(arr1, arr2)
+        return res1
+
 
 baseball_strings = [
     "new york mets vs chicago cubs",
@@ -439,3 +459,639 @@ def test_cdist_pure_python_dtype():
     assert process.cdist(["test"], ["test"], scorer=Levenshtein_py.similarity).dtype == np.int32
     assert process.cdist(["test"], ["test"], scorer=Levenshtein_py.normalized_distance).dtype == np.float32
     assert process.cdist(["test"], ["test"], scorer=Levenshtein_py.normalized_similarity).dtype == np.float32
+
+
+@pytest.mark.parametrize("scorer", [fuzz.ratio, Levenshtein.distance, custom_scorer])
+@pytest.mark.parametrize("workers", [1, 2, -1])
+def test_extract_workers(scorer, workers):
+    """
+    splitting the choices between multiple workers should not change the results
+    """
+    choices = ["".join(chars) for chars in itertools.product("abc", repeat=8)]
+    choices[5] = None
+    query = "abcabcab"
+
+    for limit in (1, 5, None):
+        assert process.extract(query, choices, scorer=scorer, limit=limit, workers=workers) == process_cpp.extract(
+            query, choices, scorer=scorer, limit=limit
+        )
+
+    assert process.extractOne(query, choices, scorer=scorer, workers=workers) == process_cpp.extractOne(
+        query, choices, scorer=scorer
+    )
+    choices_dict = dict(enumerate(choices))
+    assert process.extractOne(query, choices_dict, scorer=scorer, workers=workers) == process_cpp.extractOne(
+        query, choices_dict, scorer=scorer
+    )
+
+
+@pytest.mark.parametrize("scorer", [fuzz.ratio, Levenshtein.distance])
+def test_extract_limit_ties(scorer):
+    """
+    when the limit cuts through matches with the same score the matches
+    with the lower index should be preferred
+    """
+    choices = ["abcd", "abce", "abcd", "abcx", "abcd", "xbcd", "abcd"]
+    assert process.extract("abcd", choices, scorer=scorer, limit=3) == [
+        ("abcd", scorer("abcd", "abcd"), 0),
+        ("abcd", scorer("abcd", "abcd"), 2),
+        ("abcd", scorer("abcd", "abcd"), 4),
+    ]
+    assert process.extract("abcd", choices, scorer=scorer, limit=5)[4] == ("abce", scorer("abcd", "abce"), 1)
+
+
+@pytest.mark.parametrize(
+    "scorer",
+    [
+        fuzz.ratio,
+        fuzz.QRatio,
+        Levenshtein.distance,
+        Levenshtein.normalized_similarity,
+        Indel.distance,
+        LCSseq.similarity,
+        Hamming.distance,
+        Prefix.normalized_distance,
+    ],
+)
+@pytest.mark.parametrize("workers", [1, 2])
+def test_extract_length_bound(scorer, workers):
+    """
+    choices, which can not reach the score_cutoff based on their length, are skipped.
+    This should not change the results
+    """
+    choices = ["abc" * (i % 7) + "d" * (i % 5) + "x" * (i % 3) for i in range(3000)]
+    choices[11] = None
+    for query in ["abcabcdd", "", "d", "abcabcabcabcabcabcdddd", "abcdx"]:
+        for limit in (1, 3):
+            process.extract(query, choices, scorer=scorer, limit=limit, workers=workers)
+
+        process.extractOne(query, choices, scorer=scorer, workers=workers)
+        process.extractOne(query, choices, scorer=scorer, workers=workers, score_cutoff=scorer(query, choices[5]))
+
+
+@pytest.mark.parametrize("scorer", [fuzz.ratio, Levenshtein.distance, custom_scorer])
+@pytest.mark.parametrize("workers", [1, 2])
+def test_corpus(scorer, workers):
+    """
+    passing a Corpus should give the same results as passing the choices directly
+    """
+    choices = ["Abcd", "abce", None, "xyz", "ABCD"]
+    for mod in (process_cpp, process_py):
+        for choices_ in (choices, dict(enumerate(choices, 10))):
+            corpus = mod.Corpus(choices_, processor=utils.default_process)
+            assert len(corpus) == len(choices)
+
+            for query in ("abcd", "ABCE", None):
+                kwargs = {"scorer": scorer, "processor": utils.default_process, "workers": workers}
+                assert mod.extract(query, corpus, limit=None, **kwargs) == mod.extract(
+                    query, choices_, limit=None, **kwargs
+                )
+                assert mod.extractOne(query, corpus, **kwargs) == mod.extractOne(query, choices_, **kwargs)
+                # the choices are already preprocessed by the corpus
+                proc_query = None if query is None else utils.default_process(query)
+                assert mod.extract(proc_query, corpus, scorer=scorer, workers=workers) == mod.extract(
+                    query, choices_, **kwargs
+                )
+
+
+@pytest.mark.parametrize(
+    ("scorer", "scorer_kwargs"),
+    [
+        (fuzz.ratio, None),
+        (Levenshtein.distance, None),
+        (Levenshtein.normalized_similarity, None),
+        (Levenshtein.distance, {"weights": (1, 1, 2)}),
+        (Levenshtein.similarity, {"weights": (3, 1, 1)}),
+        (Indel.distance, None),
+        (OSA.distance, None),
+        (Hamming.distance, None),
+    ],
+)
+@pytest.mark.parametrize("workers", [1, 2])
+def test_corpus_qgram_index(scorer, scorer_kwargs, workers):
+    """
+    the q-gram index of a Corpus only skips choices, which can not reach the score_cutoff.
+    This should not change the results
+    """
+    choices = ["".join(chr(ord("a") + (i * k) % 11) for k in range(i % 13)) for i in range(2000)]
+    choices[5] = None
+    choices += ["abcdefgh", "abcdxfgh", "abdcefgh", "xabcdefg", "abcdefghij"]
+    for qgram_size in (1, 2, 3):
+        for mod in (process_cpp, process_py):
+            corpus = mod.Corpus(choices, qgram_size=qgram_size)
+            assert corpus.qgram_size == qgram_size
+            for query in ["abcdefgh", "", "a", "acegikbdfhj", "abcdefghijklmnop"]:
+                for choice in ["abcdxfgh", "abcdefghij", "acegikb"]:
+                    kwargs = {"scorer": scorer, "scorer_kwargs": scorer_kwargs, "workers": workers}
+                    kwargs["score_cutoff"] = scorer(query, choice, **(scorer_kwargs or {}))
+                    assert mod.extract(query, corpus, limit=None, **kwargs) == mod.extract(
+                        query, choices, limit=None, **kwargs
+                    )
+                    assert mod.extractOne(query, corpus, **kwargs) == mod.extractOne(query, choices, **kwargs)
+
+    for mod in (process_cpp, process_py):
+        assert mod.Corpus(choices).qgram_size is None
+        with pytest.raises(ValueError, match="qgram_size"):
+            mod.Corpus(choices, qgram_size=0)
+
+
+@pytest.mark.parametrize(
+    ("scorer", "scorer_kwargs"),
+    [
+        (Levenshtein.distance, None),
+        (Levenshtein.distance, {"weights": (2, 2, 3)}),
+        (Indel.distance, None),
+        (DamerauLevenshtein.distance, None),
+        (Hamming.distance, None),
+    ],
+)
+@pytest.mark.parametrize("workers", [1, -1])
+def test_corpus_bktree(scorer, scorer_kwargs, workers):
+    """
+    the BK-tree of a Corpus only skips choices, which can not be within the score_cutoff
+    or among the best `limit` matches. This should not change the results
+    """
+    choices = ["".join(chr(ord("a") + (i * k) % 11) for k in range(i % 13)) for i in range(2000)]
+    choices[5] = None
+    choices += ["abcdefgh", "abcdxfgh", "abdcefgh", "xabcdefg", "abcdefghij"]
+    for mod in (process_cpp, process_py):
+        corpus = mod.Corpus(choices)
+        corpus.build_bktree(scorer, scorer_kwargs=scorer_kwargs)
+        for query in ["abcdefgh", "", "a", "acegikbdfhj", "abcdefghijklmnop"]:
+            for score_cutoff in (None, 0, 2, 5):
+                kwargs = {"scorer": scorer, "scorer_kwargs": scorer_kwargs, "workers": workers}
+                kwargs["score_cutoff"] = score_cutoff
+                for limit in (1, 5, None):
+                    assert mod.extract(query, corpus, limit=limit, **kwargs) == mod.extract(
+                        query, choices, limit=limit, **kwargs
+                    )
+                assert mod.extractOne(query, corpus, **kwargs) == mod.extractOne(query, choices, **kwargs)
+
+    for mod in (process_cpp, process_py):
+        for scorer, scorer_kwargs in (
+            (OSA.distance, None),
+            (Levenshtein.normalized_distance, None),
+            (Levenshtein.distance, {"weights": (1, 2, 1)}),
+            (fuzz.ratio, None),
+        ):
+            with pytest.raises(ValueError, match="triangle inequality"):
+                mod.Corpus(choices).build_bktree(scorer, scorer_kwargs=scorer_kwargs)
+
+        # no tree can be built for scorers called through Python
+        for scorer in (Levenshtein_py.distance, lambda s1, s2, **kwargs: Levenshtein.distance(s1, s2, **kwargs)):
+            with pytest.raises(ValueError, match="C-API"):
+                mod.Corpus(choices).build_bktree(scorer)
+
+
+@pytest.mark.parametrize(
+    ("scorer", "score_cutoffs"),
+    [
+        (fuzz.ratio, [None, 50, 80, 95]),
+        (Levenshtein.distance, [None, 0, 3, 10]),
+        (Levenshtein.normalized_similarity, [None, 0.5, 0.8]),
+        (Indel.distance, [None, 0, 3, 10]),
+        (DamerauLevenshtein.distance, [None, 0, 3, 10]),
+        (Hamming.distance, [None, 0, 3, 10]),
+    ],
+)
+def test_char_signature_filter(scorer, score_cutoffs):
+    """
+    choices are only rejected based on their character signature, when they can not
+    reach the score_cutoff. This should not change the results
+    """
+    choices = ["".join(chr(ord("0") + (i * k * 7) % 60) for k in range(i % 23)) for i in range(1500)]
+    choices.append("".join(chr(ord("0") + k % 60) for k in range(300)))
+    queries = [choices[3], choices[100], "", "0", choices[200] + "x", choices[300][::-1], choices[-1]]
+    corpus = process_cpp.Corpus(choices)
+    for score_cutoff in score_cutoffs:
+        kwargs = {"scorer": scorer, "score_cutoff": score_cutoff}
+        for query in queries:
+            for limit in (1, 5, None):
+                expected = process.extract(query, choices, limit=limit, **kwargs)
+                assert process_cpp.extract(query, corpus, limit=limit, **kwargs) == expected
+            expected = process.extractOne(query, choices, **kwargs)
+            assert process_cpp.extractOne(query, corpus, **kwargs) == expected
+
+    pytest.importorskip("numpy")
+    for score_cutoff in score_cutoffs:
+        process.cdist(queries, choices, scorer=scorer, score_cutoff=score_cutoff)
+
+
+def test_corpus_cdist():
+    pytest.importorskip("numpy")
+    choices = ["Abcd", "abce", None, "xyz", "ABCD"]
+    for mod in (process_cpp, process_py):
+        corpus = mod.Corpus(choices, processor=utils.default_process)
+        expected = mod.cdist(choices, choices, processor=utils.default_process)
+        assert np.array_equal(mod.cdist(corpus, corpus), expected)
+        assert np.array_equal(mod.cdist(choices, corpus, processor=utils.default_process), expected)
+        assert np.array_equal(mod.cdist(corpus, choices, processor=utils.default_process), expected)
+
+    # the corpus can not be used with scorers which do not support None
+    with pytest.raises(TypeError):
+        process_cpp.cdist(["abcd"], process_cpp.Corpus(choices), scorer=Levenshtein.distance)
+
+
+@pytest.mark.parametrize("workers", [1, -1])
+def test_default_process_workers(workers):
+    """
+    default_process is applied to all choices in a single call split between the workers.
+    The results have to match choices, which are processed separately
+    """
+    choices = [f"  Choice-{i}: ÄBC ሴ {'x' * (i % 70)}!  " if i % 3 else f"CHOICE_{i}" for i in range(10000)]
+    choices[7] = None
+    proc_choices = [None if choice is None else utils.default_process(choice) for choice in choices]
+    corpus = process_cpp.Corpus(choices, processor=utils.default_process, workers=workers)
+    for query in ["choice 5 äbc", "CHOICE_9", ""]:
+        kwargs = {"scorer": fuzz.ratio, "processor": utils.default_process, "limit": 20}
+        expected = [res[1:] for res in process_cpp.extract(utils.default_process(query), proc_choices, limit=20)]
+        assert [res[1:] for res in process_cpp.extract(query, corpus, **kwargs)] == expected
+        assert [res[1:] for res in process_cpp.extract(query, choices, workers=workers, **kwargs)] == expected
+
+    pytest.importorskip("numpy")
+    queries = [choice for choice in choices[:100] if choice is not None]
+    proc_queries = [utils.default_process(query) for query in queries]
+    expected = process_cpp.cdist(proc_queries, proc_choices)
+    assert np.array_equal(process_cpp.cdist(queries, corpus, processor=utils.default_process), expected)
+    assert np.array_equal(
+        process_cpp.cdist(queries, choices, processor=utils.default_process, workers=workers), expected
+    )
+
+
+@pytest.mark.parametrize("scorer", [fuzz.ratio, Levenshtein.distance, custom_scorer])
+def test_corpus_file(tmp_path, scorer):
+    """
+    a saved corpus gives the same results after loading it. The files written by
+    both implementations are identical
+    """
+    choices = ["Abcd", "abce", None, "", "xyz \u00e4\u00f6\u00fc", "\u03a9mega", "\U0001f600 ABCD", "a" * 100]
+    kwargs = {"scorer": scorer, "processor": utils.default_process}
+    for processor in (None, utils.default_process):
+        files = []
+        for mod in (process_cpp, process_py):
+            path = tmp_path / f"{mod.__name__}_{processor is None}.bin"
+            mod.Corpus(choices, processor=processor).save(path)
+            files.append(path.read_bytes())
+        assert files[0] == files[1]
+
+        for save_mod in (process_cpp, process_py):
+            path = tmp_path / f"{save_mod.__name__}_{processor is None}.bin"
+            for mod in (process_cpp, process_py):
+                corpus = mod.Corpus.load(path, processor=processor)
+                assert len(corpus) == len(choices)
+                assert corpus.choices == choices
+
+                expected = mod.Corpus(choices, processor=processor)
+                for query in ("abcd", "ABCE", "\u03c9mega"):
+                    assert mod.extract(query, corpus, limit=None, **kwargs) == mod.extract(
+                        query, expected, limit=None, **kwargs
+                    )
+                    assert mod.extractOne(query, corpus, **kwargs) == mod.extractOne(query, expected, **kwargs)
+
+
+def test_corpus_file_invalid(tmp_path):
+    path = tmp_path / "corpus.bin"
+    for mod in (process_cpp, process_py):
+        with pytest.raises(TypeError):
+            mod.Corpus({"a": "abc"}).save(path)
+
+        with pytest.raises(TypeError):
+            mod.Corpus([[1, 2, 3]]).save(path)
+
+        mod.Corpus(["abc", "abd"]).save(path)
+        # the processed choices are not stored without a processor
+        with pytest.raises(ValueError, match="processed"):
+            mod.Corpus.load(path, processor=utils.default_process)
+
+        # scorers without support for the C-API would apply a different processor to the choices
+        mod.Corpus(["abc", "abd"], processor=utils.default_process).save(path)
+        for processor in (None, str.upper):
+            with pytest.raises(ValueError, match="default_process"):
+                mod.Corpus.load(path, processor=processor)
+
+        data = path.read_bytes()
+        for invalid in (data[:20], data[: len(data) // 2], b"x" * len(data)):
+            path.write_bytes(invalid)
+            with pytest.raises(ValueError):
+                mod.Corpus.load(path)
+
+
+def test_preprocessed_choices():
+    """
+    choices of different types and lengths preprocessed in a single call
+    """
+    long_choice = "xyz" * 1000
+    choices = ["", "  Abcd!", None, ["a", "b", "c", "d"], long_choice, "ABCD", [1, 2, 3]]
+    assert process.extract("abcd", choices, scorer=fuzz.ratio, limit=None) == [
+        (["a", "b", "c", "d"], 100.0, 3),
+        ("  Abcd!", pytest.approx(54.54545454545454), 1),
+        ("", 0.0, 0),
+        (long_choice, 0.0, 4),
+        ("ABCD", 0.0, 5),
+        ([1, 2, 3], 0.0, 6),
+    ]
+
+    str_choices = [x for x in choices if isinstance(x, str)]
+    assert process.extract("abcd", str_choices, scorer=fuzz.ratio, processor=utils.default_process, limit=None) == [
+        ("  Abcd!", 100.0, 1),
+        ("ABCD", 100.0, 3),
+        ("", 0.0, 0),
+        (long_choice, 0.0, 2),
+    ]
+
+
+@pytest.mark.parametrize("scorer", [Levenshtein.distance, Levenshtein.normalized_similarity, Indel.distance, OSA.distance])
+@pytest.mark.parametrize("workers", [1, 2])
+def test_cdist_mixed_lengths(scorer, workers):
+    """
+    queries and choices of different lengths are grouped into blocks for the multi string scorers
+    """
+    pytest.importorskip("numpy")
+    queries = ["a" * i + "b" * (i % 7) for i in range(0, 300, 7)]
+    choices = ["ab" * i for i in range(0, 100, 9)]
+    process.cdist(queries, choices, scorer=scorer, workers=workers)
+    process.cdist(choices, queries, scorer=scorer, workers=workers)
+    process.cdist(queries, choices, scorer=Levenshtein.distance, scorer_kwargs={"weights": (1, 2, 1)}, workers=workers)
+
+
+@pytest.mark.parametrize(
+    "scorer",
+    [
+        Levenshtein.distance,
+        Levenshtein.normalized_similarity,
+        Indel.distance,
+        Indel.normalized_similarity,
+        LCSseq.similarity,
+        OSA.distance,
+    ],
+)
+def test_cdist_long_strings(scorer):
+    """
+    strings between 65 and 256 characters are scored using multiple 64 bit words per string
+    """
+    pytest.importorskip("numpy")
+    queries = ["abcd" * (i // 4) + "xy" * (i % 5) + "\u0100" * (i % 3) for i in range(60, 300, 11)]
+    choices = [q[::-1] for q in queries[::2]] + ["dcba" * 20 + "a", "badc" * 40]
+    process.cdist(queries, choices, scorer=scorer)
+    process.cdist(queries, queries, scorer=scorer, workers=2)
+
+
+@pytest.mark.parametrize(
+    "scorer", [Levenshtein.distance, Indel.normalized_similarity, OSA.distance, fuzz.ratio, fuzz.token_sort_ratio]
+)
+@pytest.mark.parametrize("workers", [1, 2])
+def test_cdist_same_list(scorer, workers):
+    """
+    one triangle of the matrix is scored in tiles and mirrored when queries is choices
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 37) + "d" * (i % 5) for i in range(200)] + ["xyz" * 100, "zyx" * 101]
+    process.cdist(queries, queries, scorer=scorer, workers=workers)
+
+
+@pytest.mark.parametrize(
+    ("scorer", "score_cutoff", "is_similarity"),
+    [
+        (fuzz.ratio, 60, True),
+        (Levenshtein.normalized_similarity, 0.5, True),
+        (Levenshtein.distance, 3, False),
+        (Indel.distance, None, False),
+    ],
+)
+@pytest.mark.parametrize("workers", [1, 2])
+def test_cdist_sparse(scorer, score_cutoff, is_similarity, workers):
+    """
+    cdist_sparse only stores the elements of the matrix passing the score_cutoff
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(50)] + ["xyz" * 40]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) for i in range(30)]
+    data, indices, indptr = process.cdist_sparse(
+        queries, choices, scorer=scorer, score_cutoff=score_cutoff, workers=workers
+    )
+    dense = process.cdist(queries, choices, scorer=scorer, score_cutoff=score_cutoff)
+
+    if score_cutoff is None:
+        passing = np.ones(dense.shape, dtype=bool)
+    elif is_similarity:
+        passing = dense >= score_cutoff
+    else:
+        passing = dense <= score_cutoff
+
+    assert len(indptr) == len(queries) + 1
+    for row in range(len(queries)):
+        assert np.array_equal(indices[indptr[row] : indptr[row + 1]], np.nonzero(passing[row])[0])
+        assert np.array_equal(data[indptr[row] : indptr[row + 1]], dense[row][passing[row]])
+
+
+@pytest.mark.parametrize(
+    ("scorer", "score_cutoff", "is_similarity"),
+    [
+        (fuzz.ratio, 60, True),
+        (Levenshtein.normalized_similarity, 0.5, True),
+        (Levenshtein.distance, 3, False),
+        (Indel.distance, None, False),
+    ],
+)
+@pytest.mark.parametrize("limit", [1, 5, 40])
+@pytest.mark.parametrize("workers", [1, 2])
+def test_cdist_topk(scorer, score_cutoff, is_similarity, limit, workers):
+    """
+    cdist_topk returns the best limit elements of each row of cdist
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(50)] + ["xyz" * 40]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) for i in range(30)]
+    indices, scores = process.cdist_topk(
+        queries, choices, limit=limit, scorer=scorer, score_cutoff=score_cutoff, workers=workers
+    )
+    dense = process.cdist(queries, choices, scorer=scorer, score_cutoff=score_cutoff)
+
+    assert indices.shape == (len(queries), limit)
+    assert scores.shape == (len(queries), limit)
+    for row in range(len(queries)):
+        order = np.argsort(-dense[row] if is_similarity else dense[row], kind="stable")
+        if score_cutoff is not None:
+            passing = dense[row][order] >= score_cutoff if is_similarity else dense[row][order] <= score_cutoff
+            order = order[passing]
+        order = order[:limit]
+
+        assert np.array_equal(indices[row][: len(order)], order)
+        assert np.array_equal(scores[row][: len(order)], dense[row][order])
+        assert (indices[row][len(order) :] == -1).all()
+        # padded scores stay worse than all matches after the conversion to dtype
+        padding = scores[row][len(order) :]
+        if is_similarity:
+            assert (padding == 0).all()
+        else:
+            assert (padding == np.iinfo(scores.dtype).max).all()
+
+
+def test_cdist_topk_padding():
+    """
+    the worst score of distances is clamped to the range of dtype instead of wrapping around
+    """
+    pytest.importorskip("numpy")
+    for dtype in (None, np.int64, np.int8, np.uint8):
+        indices, scores = process.cdist_topk(["a"], ["b"], scorer=Levenshtein.distance, limit=3, dtype=dtype)
+        assert indices.tolist() == [[0, -1, -1]]
+        assert scores.tolist() == [[1, np.iinfo(scores.dtype).max, np.iinfo(scores.dtype).max]]
+
+
+def test_cdist_topk_none():
+    """
+    None queries have no matches and None choices are skipped
+    """
+    pytest.importorskip("numpy")
+    indices, scores = process.cdist_topk(["abc", None, "abd"], ["abc", None, "abd"], limit=3)
+    assert indices.tolist() == [[0, 2, -1], [-1, -1, -1], [2, 0, -1]]
+    assert scores[0, 0] == 100
+    assert scores[2, 0] == 100
+
+
+@pytest.mark.skipif(not hasattr(os, "fork"), reason="requires os.fork")
+def test_cdist_workers_after_fork():
+    """
+    the thread pool shared between calls is recreated in a forked child
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) for i in range(100)]
+    expected = process.cdist(queries, queries, workers=2)
+    process.cdist(queries, queries, workers=3)
+
+    pid = os.fork()
+    if pid == 0:
+        status = 0
+        try:
+            if not np.array_equal(process_cpp.cdist(queries, queries, workers=2), expected):
+                status = 1
+        except BaseException:
+            status = 1
+        os._exit(status)
+
+    _, status = os.waitpid(pid, 0)
+    assert status == 0
+
+
+def test_extractOne_threads():
+    """
+    extractOne releases the GIL while scoring, so it can be called from multiple threads at once
+    """
+    from concurrent.futures import ThreadPoolExecutor
+
+    choices = ["abc" * (i % 7) + "d" * (i % 5) for i in range(3000)]
+    queries = ["abcabcdd", "dddd", "abcabcabcabc", "xyz"]
+    expected = [process.extractOne(query, choices, scorer=fuzz.ratio) for query in queries]
+
+    with ThreadPoolExecutor(4) as executor:
+        for _ in range(5):
+            results = list(
+                executor.map(lambda query: process_cpp.extractOne(query, choices, scorer=fuzz.ratio), queries)
+            )
+            assert results == expected
+
+
+@pytest.mark.parametrize("choices", [["abc"] + ["abd"] * 5000, {i: "abd" if i else "abc" for i in range(5001)}])
+def test_extractOne_perfect_match_stops_processing(choices):
+    """
+    extractOne does not preprocess the choices after a perfect match
+    """
+    for module in (process_cpp, process_py):
+        calls = 0
+
+        def processor(s):
+            nonlocal calls
+            calls += 1
+            return s
+
+        result = module.extractOne("abc", choices, scorer=fuzz.ratio, processor=processor)
+        assert result == ("abc", 100, 0)
+        assert calls < len(choices) // 2
+
+
+@pytest.mark.parametrize("scorer", [Levenshtein.distance, Indel.normalized_similarity, fuzz.token_sort_ratio])
+@pytest.mark.parametrize("workers", [1, 2])
+def test_cdist_many_choices(scorer, workers):
+    """
+    the choices are split into multiple tiles, which are scored against blocks of queries
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(20)] + ["xyz" * 100]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) + "e" * (i % 11) for i in range(6000)]
+    process.cdist(queries, choices, scorer=scorer, workers=workers)
+
+
+@pytest.mark.parametrize(
+    ("scorer", "scale"),
+    [(fuzz.ratio, 1), (Levenshtein.normalized_similarity, 100), (Indel.normalized_distance, 100)],
+)
+def test_cdist_uint8(scorer, scale):
+    """
+    scores of floating point scorers are stored as 0-100 when using dtype=np.uint8
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(30)]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) for i in range(20)]
+    expected = np.floor(process.cdist(queries, choices, scorer=scorer, dtype=np.float64) * scale + 0.5)
+    assert np.array_equal(process.cdist(queries, choices, scorer=scorer, dtype=np.uint8), expected)
+
+    expected = np.floor(process.cdist(queries, queries, scorer=scorer, dtype=np.float64) * scale + 0.5)
+    assert np.array_equal(process.cdist(queries, queries, scorer=scorer, dtype=np.uint8, workers=2), expected)
+
+
+def test_cdist_out():
+    """
+    cdist writes into the strided view passed as out in place
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(30)]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) for i in range(20)]
+
+    for choices_ in (choices, queries):
+        expected = process.cdist(queries, choices_, scorer=Levenshtein.distance)
+        matrix = np.full((2 * len(queries) + 3, 3 * len(choices_)), -1, dtype=np.int32)
+        out = matrix[3::2, ::3]
+        res = process.cdist(queries, choices_, scorer=Levenshtein.distance, workers=2, out=out)
+        assert res is out
+        assert np.array_equal(out, expected)
+        assert np.count_nonzero(matrix == -1) == matrix.size - out.size
+
+
+def test_cdist_out_memmap(tmp_path):
+    """
+    blocks of a memory mapped matrix can be filled one after another
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc" * (i % 7) + "d" * (i % 5) for i in range(30)]
+    choices = ["abcd" * (i % 4) + "c" * (i % 3) for i in range(20)]
+    expected = process.cdist(queries, choices, dtype=np.uint8)
+
+    matrix = np.memmap(tmp_path / "matrix.bin", dtype=np.uint8, mode="w+", shape=(len(queries), len(choices)))
+    for row in range(0, len(queries), 7):
+        for col in range(0, len(choices), 6):
+            block = matrix[row : row + 7, col : col + 6]
+            process.cdist(queries[row : row + 7], choices[col : col + 6], out=block)
+    matrix.flush()
+
+    assert np.array_equal(np.fromfile(tmp_path / "matrix.bin", dtype=np.uint8).reshape(matrix.shape), expected)
+
+
+@pytest.mark.parametrize("cdist", [process_cpp.cdist, process_py.cdist])
+def test_cdist_out_invalid(cdist):
+    """
+    out needs to be writable and match the shape and dtype of the result
+    """
+    pytest.importorskip("numpy")
+    queries = ["abc", "abd"]
+    choices = ["abc", "bcd", "cde"]
+
+    with pytest.raises(ValueError, match="shape"):
+        cdist(queries, choices, out=np.zeros((3, 2), dtype=np.float32))
+
+    with pytest.raises(ValueError, match="dtype"):
+        cdist(queries, choices, dtype=np.float64, out=np.zeros((2, 3), dtype=np.float32))
+
+    out = np.zeros((2, 3), dtype=np.float32)
+    out.flags.writeable = False
+    with pytest.raises(ValueError, match="writable"):
+        cdist(queries, choices, out=out)
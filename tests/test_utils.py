@@ -1,6 +1,6 @@
 from __future__ import annotations
 
-from rapidfuzz import utils
+from rapidfuzz import utils, utils_py
 
 
 def test_fullProcess():
@@ -25,3 +25,32 @@ def test_fullProcess():
 
     for string, proc_string in zip(mixed_strings, mixed_strings_proc):
         assert utils.default_process(string) == proc_string
+
+
+def test_default_process_blocks():
+    """
+    default_process processes blocks of ascii characters using simd. Characters outside
+    of ascii and whitespaces are placed at each position of these blocks
+    """
+
+    def expected(sentence):
+        return "".join(ch.lower() if ch.isalnum() else " " for ch in sentence).strip(" ")
+
+    base = "  Lorem-Ipsum: DOLOR sit_amet 0123456789 @[`{ ~/:  " * 3
+    for special in ["Ä", "ß", "¬", "Ω", "ሴ", "€"]:
+        for pos in range(len(base)):
+            sentence = base[:pos] + special + base[pos:]
+            assert utils.default_process(sentence) == expected(sentence)
+
+        sentence = " " * 70 + special + " " * 70
+        assert utils.default_process(sentence) == expected(sentence)
+
+    assert utils.default_process(" " * 100) == ""
+
+
+def test_default_process_list():
+    sentences = ["Lorem-Ipsum: DOLOR", "C'est la vie", "Ça va?", "a¬ሴ€耀", "", " " * 100] * 1000
+    expected = [utils_py.default_process(sentence) for sentence in sentences]
+    for workers in (1, 4):
+        assert utils.default_process_list(sentences, workers=workers) == expected
+        assert utils_py.default_process_list(sentences, workers=workers) == expected